@@ -35,6 +35,7 @@
 
 */
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <math.h>
 #include <complex.h>
@@ -66,6 +67,12 @@ fft_config_t *fft_init(int size, fft_type_t type, fft_direction_t direction, flo
   config->direction = direction;
   config->size = size;
 
+  config->input_q15 = NULL;
+  config->output_q15 = NULL;
+  config->twiddle_factors_q15 = NULL;
+  config->work_q15 = NULL;
+  config->exponent = 0;
+
   // Allocate and precompute twiddle factors
   config->twiddle_factors = (float *)malloc(2 * config->size * sizeof(float));
 
@@ -112,8 +119,102 @@ fft_config_t *fft_init(int size, fft_type_t type, fft_direction_t direction, flo
   return config;
 }
 
+fft_config_t *fft_init_q15(int size, fft_type_t type, fft_direction_t direction, int16_t *input, int32_t *output)
+{
+  /*
+   * Prepare a fixed-point FFT, only the forward real transform is supported.
+   *
+   * The input holds 16-bit samples, the output has the same layout as rfft()
+   * and is scaled by 2^exponent after each call to fft_execute().
+   *
+   * If no input or output buffers are provided, they will be allocated.
+   */
+  int k;
+
+  if (type != FFT_REAL || direction != FFT_FORWARD)
+    return NULL;
+
+  // Check if the size is a power of two
+  if (size < 4 || (size & (size-1)) != 0)
+    return NULL;
+
+  fft_config_t *config = (fft_config_t *)calloc(1, sizeof(fft_config_t));
+
+  if (config == NULL)
+    return NULL;
+
+  // start configuration
+  config->flags = FFT_FIXED_POINT;
+  config->type = type;
+  config->direction = direction;
+  config->size = size;
+
+  // Only the first half of the twiddle factors is used by rfft_q15()
+  config->twiddle_factors_q15 = (int16_t *)malloc(config->size * sizeof(int16_t));
+  config->work_q15 = (int16_t *)malloc(config->size * sizeof(int16_t));
+
+  if (config->twiddle_factors_q15 == NULL || config->work_q15 == NULL)
+  {
+    fft_destroy(config);
+    return NULL;
+  }
+
+  float two_pi_by_n = TWO_PI / config->size;
+
+  for (k = 0 ; k < config->size / 2 ; k++)
+  {
+    float c = cosf(two_pi_by_n * k) * 32768.0f;
+    float s = sinf(two_pi_by_n * k) * 32768.0f;
+
+    // 1.0 does not fit in Q15
+    config->twiddle_factors_q15[2*k]   = c > 32767.0f ? 32767 : (int16_t)lrintf(c);  // real
+    config->twiddle_factors_q15[2*k+1] = s > 32767.0f ? 32767 : (int16_t)lrintf(s);  // imag
+  }
+
+  // Allocate input buffer
+  if (input != NULL)
+    config->input_q15 = input;
+  else
+  {
+    config->input_q15 = (int16_t *)malloc(config->size * sizeof(int16_t));
+    config->flags |= FFT_OWN_INPUT_MEM;
+  }
+
+  // Allocate output buffer
+  if (output != NULL)
+    config->output_q15 = output;
+  else
+  {
+    config->output_q15 = (int32_t *)malloc(config->size * sizeof(int32_t));
+    config->flags |= FFT_OWN_OUTPUT_MEM;
+  }
+
+  if (config->input_q15 == NULL || config->output_q15 == NULL)
+  {
+    fft_destroy(config);
+    return NULL;
+  }
+
+  return config;
+}
+
 void fft_destroy(fft_config_t *config)
 {
+  if (config->flags & FFT_FIXED_POINT)
+  {
+    if (config->flags & FFT_OWN_INPUT_MEM)
+      free(config->input_q15);
+
+    if (config->flags & FFT_OWN_OUTPUT_MEM)
+      free(config->output_q15);
+
+    free(config->twiddle_factors_q15);
+    free(config->work_q15);
+    free(config);
+
+    return;
+  }
+
   if (config->flags & FFT_OWN_INPUT_MEM)
     free(config->input);
 
@@ -126,7 +227,9 @@ void fft_destroy(fft_config_t *config)
 
 void fft_execute(fft_config_t *config)
 {
-  if (config->type == FFT_REAL && config->direction == FFT_FORWARD)
+  if (config->flags & FFT_FIXED_POINT)
+    config->exponent = rfft_q15(config->input_q15, config->output_q15, config->work_q15, config->twiddle_factors_q15, config->size);
+  else if (config->type == FFT_REAL && config->direction == FFT_FORWARD)
     rfft(config->input, config->output, config->twiddle_factors, config->size);
   else if (config->type == FFT_REAL && config->direction == FFT_BACKWARD)
     irfft(config->input, config->output, config->twiddle_factors, config->size);
@@ -269,6 +372,163 @@ void irfft(float *x, float *y, float *twiddle_factors, int n)
   ifft_primitive(x, y, n / 2, 2, twiddle_factors, 4);
 }
 
+static inline int32_t fft_abs_q15(int32_t v)
+{
+  return v < 0 ? -v : v;
+}
+
+static inline int32_t fft_max_q15(int32_t a, int32_t b)
+{
+  return a > b ? a : b;
+}
+
+int rfft_q15(int16_t *x, int32_t *y, int16_t *work, int16_t *twiddle_factors, int n)
+{
+  /*
+   * Forward real FFT in fixed point with block floating point
+   *
+   * The n real samples are packed into n/2 complex ones and transformed by
+   * an in-place radix-2 DIT FFT on 16-bit data. The input block is first
+   * normalized so that quiet signals keep their precision, then before each
+   * stage it is scaled down just enough that the butterflies, whose outputs
+   * can grow to (1 + sqrt(2)) times the largest input, cannot overflow.
+   *
+   * Parameters
+   * ----------
+   *  x (int16_t *)
+   *    The n real input samples, left untouched
+   *  y (int32_t *)
+   *    The output in the same layout as rfft(), [X0, X(n/2), Re(X1), Im(X1), ...]
+   *  work (int16_t *)
+   *    Scratch buffer of n samples
+   *  twiddle_factors (int16_t *)
+   *    The first n/2 Q15 twiddle factors of size n, real/imaginary interleaved
+   *  n (int)
+   *    The FFT size, should be a power of 2
+   *
+   * Returns the block exponent, the true spectrum is y * 2^exponent.
+   */
+  int m = n / 2;
+  int exponent = 0;
+  int32_t peak = 0;
+  int i, j, k, len, norm;
+
+  for (k = 0 ; k < n ; k++)
+    peak = fft_max_q15(peak, fft_abs_q15(x[k]));
+
+  // normalize the block into the range the first stage can take without scaling
+  if (peak != 0)
+  {
+    while ((peak << 1) <= 13572)
+    {
+      peak <<= 1;
+      exponent--;
+    }
+  }
+
+  norm = -exponent;
+
+  // bit-reversed copy, the even and odd samples form the real and imaginary parts
+  for (i = 0, j = 0 ; i < m ; i++)
+  {
+    work[2*j]   = x[2*i]   * (1 << norm);
+    work[2*j+1] = x[2*i+1] * (1 << norm);
+
+    for (k = m >> 1 ; j & k ; k >>= 1)
+      j ^= k;
+    j |= k;
+  }
+
+  for (len = 2 ; len <= m ; len <<= 1)
+  {
+    int shift = peak > 27145 ? 2 : (peak > 13572 ? 1 : 0);
+    int32_t round = shift ? 1 << (shift - 1) : 0;
+    int half = len / 2;
+    int tw_stride = 2 * (m / len) * 2;
+
+    exponent += shift;
+    peak = 0;
+
+    for (i = 0 ; i < m ; i += len)
+    {
+      for (j = 0 ; j < half ; j++)
+      {
+        int16_t *a = work + 2 * (i + j);
+        int16_t *b = work + 2 * (i + j + half);
+        int32_t c = twiddle_factors[j * tw_stride];
+        int32_t s = twiddle_factors[j * tw_stride + 1];
+
+        // b * conj(w)
+        int32_t tr = (c * b[0] + s * b[1] + (1 << 14)) >> 15;
+        int32_t ti = (c * b[1] - s * b[0] + (1 << 14)) >> 15;
+
+        int32_t ar = a[0];
+        int32_t ai = a[1];
+
+        a[0] = (ar + tr + round) >> shift;
+        a[1] = (ai + ti + round) >> shift;
+        b[0] = (ar - tr + round) >> shift;
+        b[1] = (ai - ti + round) >> shift;
+
+        // track the peak for the next stage
+        peak = fft_max_q15(peak, fft_max_q15(fft_abs_q15(a[0]), fft_abs_q15(a[1])));
+        peak = fft_max_q15(peak, fft_max_q15(fft_abs_q15(b[0]), fft_abs_q15(b[1])));
+      }
+    }
+  }
+
+  // Post processing as in rfft(), computed at twice the scale to keep the LSB
+  y[0] = 2 * ((int32_t)work[0] + work[1]);  // DC coefficient
+  y[1] = 2 * ((int32_t)work[0] - work[1]);  // Center coefficient
+
+  y[n/2]   =  2 * (int32_t)work[n/2];
+  y[n/2+1] = -2 * (int32_t)work[n/2+1];
+
+  for (k = 2 ; k < n / 2 ; k += 2)
+  {
+    int32_t xer, xei, xor, xoi, c, s, tr, ti;
+
+    c = twiddle_factors[k];
+    s = twiddle_factors[k+1];
+
+    // even half coefficient
+    xer = (int32_t)work[k] + work[n-k];
+    xei = (int32_t)work[k+1] - work[n-k+1];
+
+    // odd half coefficient
+    xor = (int32_t)work[k+1] + work[n-k+1];
+    xoi = -((int32_t)work[k] - work[n-k]);
+
+    tr = ( (int64_t)c * xor + (int64_t)s * xoi + (1 << 14)) >> 15;
+    ti = (-(int64_t)s * xor + (int64_t)c * xoi + (1 << 14)) >> 15;
+
+    y[k]   = xer + tr;
+    y[k+1] = xei + ti;
+
+    y[n-k]   =   xer - tr;
+    y[n-k+1] = -(xei - ti);
+  }
+
+  return exponent - 1;
+}
+
+uint32_t fft_magnitude_q15(int32_t re, int32_t im)
+{
+  /*
+   * Alpha max plus beta min approximation of sqrt(re^2 + im^2)
+   *
+   * alpha = 0.96043387, beta = 0.39782473, largest error 3.96 %
+   */
+  uint32_t a = re < 0 ? -re : re;
+  uint32_t b = im < 0 ? -im : im;
+  uint32_t mx = a > b ? a : b;
+  uint32_t mn = a > b ? b : a;
+
+  uint32_t m = ((uint64_t)mx * 31471 + (uint64_t)mn * 13036) >> 15;
+
+  return m > mx ? m : mx;
+}
+
 void fft_primitive(float *x, float *y, int n, int stride, float *twiddle_factors, int tw_stride)
 {
   /*
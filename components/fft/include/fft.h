@@ -37,6 +37,8 @@
 #ifndef __FFT_H__
 #define __FFT_H__
 
+#include <stdint.h>
+
 typedef enum
 {
   FFT_REAL,
@@ -51,6 +53,7 @@ typedef enum
 
 #define FFT_OWN_INPUT_MEM 1
 #define FFT_OWN_OUTPUT_MEM 2
+#define FFT_FIXED_POINT 4
 
 typedef struct
 {
@@ -61,15 +64,23 @@ typedef struct
   fft_type_t type;   // real or complex
   fft_direction_t direction; // forward or backward
   unsigned int flags; // FFT flags
+  int16_t *input_q15;  // pointer to fixed-point input buffer
+  int32_t *output_q15; // pointer to fixed-point output buffer
+  int16_t *twiddle_factors_q15; // Q15 twiddle factors of the fixed-point path
+  int16_t *work_q15;   // scratch buffer of the fixed-point path
+  int exponent;  // block exponent of the last fixed-point output, value = output * 2^exponent
 } fft_config_t;
 
 fft_config_t *fft_init(int size, fft_type_t type, fft_direction_t direction, float *input, float *output);
+fft_config_t *fft_init_q15(int size, fft_type_t type, fft_direction_t direction, int16_t *input, int32_t *output);
 void fft_destroy(fft_config_t *config);
 void fft_execute(fft_config_t *config);
 void fft(float *input, float *output, float *twiddle_factors, int n);
 void ifft(float *input, float *output, float *twiddle_factors, int n);
 void rfft(float *x, float *y, float *twiddle_factors, int n);
 void irfft(float *x, float *y, float *twiddle_factors, int n);
+int rfft_q15(int16_t *x, int32_t *y, int16_t *work, int16_t *twiddle_factors, int n);
+uint32_t fft_magnitude_q15(int32_t re, int32_t im);
 void fft_primitive(float *x, float *y, int n, int stride, float *twiddle_factors, int tw_stride);
 void split_radix_fft(float *x, float *y, int n, int stride, float *twiddle_factors, int tw_stride);
 void ifft_primitive(float *input, float *output, int n, int stride, float *twiddle_factors, int tw_stride);
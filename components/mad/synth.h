@@ -29,6 +29,7 @@ struct mad_pcm {
   unsigned int samplerate;		/* sampling frequency (Hz) */
   unsigned short channels;		/* number of channels */
   unsigned short length;		/* number of samples per channel */
+  signed short samples[1152 * 2];	/* interleaved L/R PCM output */
 };
 
 struct mad_synth {
@@ -604,7 +604,6 @@ void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
   register mad_fixed64hi_t hi;
   register mad_fixed64lo_t lo;
   mad_fixed_t raw_sample;
-  short int short_sample_buff[2][32];
 
   phase = synth->phase;
 
@@ -613,14 +612,11 @@ void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
 
   for (s = 0; s < ns; ++s)
   {
-    memset (short_sample_buff[0], 0x00, sizeof(short_sample_buff[0]));
-    memset (short_sample_buff[1], 0x00, sizeof(short_sample_buff[0]));
-
     for (ch = 0; ch < nch; ++ch)
     {
       sbsample = (void*) &frame->sbsample[ch];
       filter   = &synth->filter[ch];
-      pcm1     = short_sample_buff[ch];
+      pcm1     = &synth->pcm.samples[s * 32 * 2 + ch];
 
       dct32((*sbsample)[s], phase >> 1,
 	    (*filter)[0][phase & 1], (*filter)[1][phase & 1]);
@@ -659,8 +655,9 @@ void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
 
       raw_sample = SHIFT(MLZ(hi, lo));
       raw_sample = scale(raw_sample);
-      (*pcm1++) += (short int)raw_sample;
-      pcm2 = pcm1 + 30;
+      *pcm1 = (short int)raw_sample;
+      pcm1 += 2;
+      pcm2 = pcm1 + 60;
 
       for (sb = 1; sb < 16; ++sb)
       {
@@ -693,7 +690,8 @@ void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
 
         raw_sample = SHIFT(MLZ(hi, lo));
         raw_sample = scale(raw_sample);
-        (*pcm1++) += (short int)raw_sample;
+        *pcm1 = (short int)raw_sample;
+        pcm1 += 2;
 
         ptr = *Dptr - pe;
         ML0(hi, lo, (*fe)[0], ptr[31 - 16]);
@@ -717,7 +715,8 @@ void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
 
         raw_sample = SHIFT(MLZ(hi, lo));
         raw_sample = scale(raw_sample);
-        (*pcm2--) += (short int)raw_sample;
+        *pcm2 = (short int)raw_sample;
+        pcm2 -= 2;
 
         ++fo;
       }
@@ -736,13 +735,10 @@ void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
 
       raw_sample = SHIFT(-MLZ(hi, lo));
       raw_sample = scale(raw_sample);
-      (*pcm1) += (short int)raw_sample;
+      *pcm1 = (short int)raw_sample;
 
     }  /* Channel For */
 
-    /* Render block */
-    render_sample_block(short_sample_buff[0], short_sample_buff[1], 32, nch);
-
     phase = (phase + 1) % 16;
 
   } /* Block for */
@@ -766,7 +762,6 @@ void synth_half(struct mad_synth *synth, struct mad_frame const *frame,
   register mad_fixed64hi_t hi;
   register mad_fixed64lo_t lo;
   mad_fixed_t raw_sample;
-  short int short_sample_buff[2][16];
 
   phase = synth->phase;
 
@@ -775,14 +770,11 @@ void synth_half(struct mad_synth *synth, struct mad_frame const *frame,
 
   for (s = 0; s < ns; ++s)
   {
-    memset (short_sample_buff[0], 0x00, sizeof(short_sample_buff[0]));
-    memset (short_sample_buff[1], 0x00, sizeof(short_sample_buff[0]));
-
     for (ch = 0; ch < nch; ++ch)
     {
       sbsample = (void *) &frame->sbsample[ch];
       filter   = &synth->filter[ch];
-      pcm1 = short_sample_buff[ch];
+      pcm1 = &synth->pcm.samples[s * 16 * 2 + ch];
 
       dct32((*sbsample)[s], phase >> 1,
 	    (*filter)[0][phase & 1], (*filter)[1][phase & 1]);
@@ -821,8 +813,9 @@ void synth_half(struct mad_synth *synth, struct mad_frame const *frame,
 
       raw_sample = SHIFT(MLZ(hi, lo));
       raw_sample = scale(raw_sample);
-      (*pcm1++) += (short int)raw_sample;
-      pcm2 = pcm1 + 14;
+      *pcm1 = (short int)raw_sample;
+      pcm1 += 2;
+      pcm2 = pcm1 + 28;
 
       for (sb = 1; sb < 16; ++sb)
       {
@@ -855,7 +848,8 @@ void synth_half(struct mad_synth *synth, struct mad_frame const *frame,
 
         raw_sample = SHIFT(MLZ(hi, lo));
         raw_sample = scale(raw_sample);
-        (*pcm1++) += (short int)raw_sample;
+        *pcm1 = (short int)raw_sample;
+        pcm1 += 2;
 
         ptr = *Dptr - pe;
         ML0(hi, lo, (*fe)[0], ptr[31 - 16]);
@@ -879,7 +873,8 @@ void synth_half(struct mad_synth *synth, struct mad_frame const *frame,
 
         raw_sample = SHIFT(MLZ(hi, lo));
         raw_sample = scale(raw_sample);
-        (*pcm2--) += (short int)raw_sample;
+        *pcm2 = (short int)raw_sample;
+        pcm2 -= 2;
 
         ++fo;
       }
@@ -898,13 +893,10 @@ void synth_half(struct mad_synth *synth, struct mad_frame const *frame,
 
       raw_sample = SHIFT(-MLZ(hi, lo));
       raw_sample = scale(raw_sample);
-      (*pcm1) += (short int)raw_sample;
+      *pcm1 = (short int)raw_sample;
 
     } /* Channel For */
 
-    /* Block render */
-    render_sample_block(short_sample_buff[0], short_sample_buff[1], 16, nch);
-
     phase = (phase + 1) % 16;
 
   }/* Block For */
@@ -5,6 +5,9 @@
  *      Author: Jack Chen <redchenjs@live.com>
  */
 
+#include <math.h>
+#include <string.h>
+
 #include "gfx.h"
 
 #if GFX_USE_GDISP
@@ -46,6 +49,58 @@
 
 #include "CUBE0414.h"
 
+#ifdef CONFIG_LIGHT_CUBE_TEMPORAL_DITHER
+#ifdef CONFIG_LIGHT_CUBE_DITHER_BENCHMARK
+#include "esp_log.h"
+#include "xtensa/hal.h"
+
+#define BENCH_FRAMES    (256)
+#endif
+
+#define CUBE0414_GAMMA          2.2
+// longest gap between two dithered frames, a full 16-step cycle takes 16 of them
+#define CUBE0414_DITHER_PERIOD  8
+
+// g->priv keeps the 8-bit frame, the dithered copies are sent from gram_buff
+static uint8_t *gram_buff[2] = {NULL};
+static uint8_t gram_idx = 0;
+static uint8_t gram_frame = 0;
+static volatile bool_t gram_dithering = FALSE;
+static volatile systemticks_t gram_sent = 0;
+static gfxSem gram_wake;
+
+// gamma-corrected levels with 4 extra bits, full scale is 255 << 4 so adding the dither never overflows
+static uint16_t gram_gamma[256] = {0};
+// bit-reversed frame counter, the extra bits come on spread evenly over 16 frames
+static const uint8_t gram_dither[16] = {0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+
+// the effects flush at their own pace or not at all, this keeps the dither stepping in between
+static DECLARE_THREAD_FUNCTION(gram_dither_thread, param) {
+    GDisplay *g = (GDisplay *)param;
+    systemticks_t period = gfxMillisecondsToTicks(CUBE0414_DITHER_PERIOD);
+
+    while (1) {
+        if (!gram_dithering) {
+            gfxSemWait(&gram_wake, TIME_INFINITE);
+            continue;
+        }
+
+        systemticks_t idle = gfxSystemTicks() - gram_sent;
+        if (idle < period) {
+            gfxSleepMilliseconds((period - idle) * portTICK_PERIOD_MS);
+            continue;
+        }
+
+        gdispGFlush(g);
+    }
+
+    THREAD_RETURN(0);
+}
+#else
+// g->priv is always the back buffer, the front one is owned by the SPI DMA until it is sent out
+static uint8_t *gram_buff[2] = {NULL};
+#endif
+
 LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     g->priv = gfxAlloc(GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 3);
     if (g->priv == NULL) {
@@ -56,6 +111,26 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
         *((uint8_t *)g->priv + i) = 0x00;
     }
 
+#ifdef CONFIG_LIGHT_CUBE_TEMPORAL_DITHER
+    gram_buff[0] = gfxAlloc(GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 3);
+    if (gram_buff[0] == NULL) {
+        gfxHalt("GDISP CUBE0414: Failed to allocate private memory");
+    }
+    // without the second buffer it waits for each transfer before dithering the next frame
+    gram_buff[1] = gfxAlloc(GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 3);
+
+    for (int i=0; i<256; i++) {
+        gram_gamma[i] = pow(i / 255.0, CUBE0414_GAMMA) * (255 << 4) + 0.5;
+    }
+
+    gfxSemInit(&gram_wake, 0, 1);
+    gfxThreadCreate(0, 2048, NORMAL_PRIORITY, gram_dither_thread, g);
+#else
+    gram_buff[0] = (uint8_t *)g->priv;
+    // without the second buffer it falls back to drawing into the one being sent
+    gram_buff[1] = gfxAlloc(GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 3);
+#endif
+
     // Initialise the board interface
     init_board(g);
 
@@ -73,12 +148,83 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     return TRUE;
 }
 
-#if GDISP_HARDWARE_FLUSH
+#if GDISP_HARDWARE_FLUSH && defined(CONFIG_LIGHT_CUBE_TEMPORAL_DITHER)
+    LLDSPEC void gdisp_lld_flush(GDisplay *g) {
+        const uint8_t *src = (const uint8_t *)g->priv;
+        uint8_t *dst = gram_buff[gram_idx];
+        uint16_t frac = 0;
+#ifdef CONFIG_LIGHT_CUBE_DITHER_BENCHMARK
+        static uint32_t bench_frames = 0;
+        static uint32_t bench_cycles = 0;
+#endif
+
+        // an unchanged frame still has to be sent while some levels sit between two steps
+        if (!(g->flags & GDISP_FLG_NEEDFLUSH) && !gram_dithering) {
+            return;
+        }
+
+        if (!gram_buff[1]) {
+            wait_gram(g);
+        }
+
+#ifdef CONFIG_LIGHT_CUBE_DITHER_BENCHMARK
+        uint32_t start = xthal_get_ccount();
+#endif
+        for (int i=0; i<GDISP_SCREEN_HEIGHT*GDISP_SCREEN_WIDTH; i++) {
+            uint8_t d = gram_dither[(gram_frame + i) & 0x0F];
+
+            for (int k=0; k<3; k++) {
+                uint16_t c = gram_gamma[*src++];
+
+                frac |= c;
+                *dst++ = (c + d) >> 4;
+            }
+        }
+
+#ifdef CONFIG_LIGHT_CUBE_DITHER_BENCHMARK
+        bench_cycles += xthal_get_ccount() - start;
+        if (++bench_frames == BENCH_FRAMES) {
+            ESP_LOGI("CUBE0414", "dither: %u cycles per frame", bench_cycles / BENCH_FRAMES);
+            bench_frames = 0;
+            bench_cycles = 0;
+        }
+#endif
+
+        refresh_gram(g, gram_buff[gram_idx]);
+
+        if (gram_buff[1]) {
+            gram_idx ^= 1;
+        }
+        gram_frame++;
+        gram_sent = gfxSystemTicks();
+
+        if ((frac & 0x0F) != 0) {
+            if (!gram_dithering) {
+                gram_dithering = TRUE;
+                gfxSemSignal(&gram_wake);
+            }
+        } else {
+            gram_dithering = FALSE;
+        }
+
+        g->flags &= ~GDISP_FLG_NEEDFLUSH;
+    }
+#elif GDISP_HARDWARE_FLUSH
     LLDSPEC void gdisp_lld_flush(GDisplay *g) {
         if (!(g->flags & GDISP_FLG_NEEDFLUSH)) {
             return;
         }
-        refresh_gram(g, (uint8_t *)g->priv);
+        if (gram_buff[1]) {
+            uint8_t *front = (uint8_t *)g->priv;
+            // the other buffer is free again once its last transfer has finished
+            wait_gram(g);
+            g->priv = (front == gram_buff[0]) ? gram_buff[1] : gram_buff[0];
+            refresh_gram(g, front);
+            // the next frame starts from this one
+            memcpy(g->priv, front, GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 3);
+        } else {
+            refresh_gram(g, (uint8_t *)g->priv);
+        }
         g->flags &= ~GDISP_FLG_NEEDFLUSH;
     }
 #endif
@@ -119,6 +265,25 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     }
 #endif
 
+#if GDISP_HARDWARE_BITFILLS
+    LLDSPEC void gdisp_lld_blit_area(GDisplay *g) {
+        const pixel_t *src = (const pixel_t *)g->p.ptr + g->p.x1 + g->p.y1 * g->p.x2;
+        uint8_t *row = (uint8_t *)g->priv + (g->p.x + g->p.y * g->g.Width) * 3;
+        for (coord_t y=0; y<g->p.cy; y++) {
+            uint8_t *p = row;
+            for (coord_t x=0; x<g->p.cx; x++) {
+                LLDCOLOR_TYPE c = gdispColor2Native(src[x]);
+                *p++ = c >> 16;
+                *p++ = c >> 8;
+                *p++ = c;
+            }
+            src += g->p.x2;
+            row += g->g.Width * 3;
+        }
+        g->flags |= GDISP_FLG_NEEDFLUSH;
+    }
+#endif
+
 #if GDISP_HARDWARE_STREAM_READ
     static int8_t stream_read_x  = 0;
     static int8_t stream_read_cx = 0;
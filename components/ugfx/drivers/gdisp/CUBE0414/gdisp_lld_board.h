@@ -15,5 +15,6 @@
 #define write_data(g, data)     cube0414_write_data(data)
 #define write_buff(g, buff, n)  cube0414_write_buff(buff, n)
 #define refresh_gram(g, gram)   cube0414_refresh_gram(gram)
+#define wait_gram(g)            cube0414_wait_gram()
 
 #endif /* _GDISP_LLD_BOARD_H */
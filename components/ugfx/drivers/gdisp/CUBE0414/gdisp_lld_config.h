@@ -17,6 +17,7 @@
 #define GDISP_HARDWARE_FLUSH            TRUE
 #define GDISP_HARDWARE_STREAM_WRITE     TRUE
 #define GDISP_HARDWARE_STREAM_READ      TRUE
+#define GDISP_HARDWARE_BITFILLS         TRUE
 #define GDISP_HARDWARE_CONTROL          TRUE
 
 #define GDISP_LLD_PIXELFORMAT           GDISP_PIXELFORMAT_RGB888
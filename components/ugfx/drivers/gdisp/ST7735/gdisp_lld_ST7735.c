@@ -5,6 +5,8 @@
  *      Author: Jack Chen <redchenjs@live.com>
  */
 
+#include <string.h>
+
 #include "gfx.h"
 
 #if GFX_USE_GDISP
@@ -46,6 +48,58 @@
 
 #include "ST7735.h"
 
+// g->priv is always the back buffer, the front one is owned by the SPI DMA until it is sent out
+static uint8_t *gram_buff[2] = {NULL};
+
+// rows changed since the last flush, sent as a few row windows
+static uint8_t gram_dirty[GDISP_SCREEN_WIDTH] = {0};
+
+// a new window costs about as much as sending one more row, so gaps this small are sent along
+#define GRAM_MERGE_GAP              1
+
+static void gram_mark_dirty(coord_t y, coord_t cy) {
+    if (y < 0) {
+        cy += y;
+        y = 0;
+    }
+    if (y + cy > GDISP_SCREEN_WIDTH) {
+        cy = GDISP_SCREEN_WIDTH - y;
+    }
+    if (cy > 0) {
+        memset(gram_dirty + y, 1, cy);
+    }
+}
+
+static uint8_t gram_get_bands(gram_band_t *band) {
+    uint8_t band_num = 0;
+    coord_t y = 0;
+
+    while (y < GDISP_SCREEN_WIDTH) {
+        if (!gram_dirty[y]) {
+            y++;
+            continue;
+        }
+
+        coord_t y0 = y;
+        while (y < GDISP_SCREEN_WIDTH && gram_dirty[y]) {
+            y++;
+        }
+
+        if (band_num != 0 && (y0 - band[band_num - 1].y1 <= GRAM_MERGE_GAP || band_num == GRAM_BANDS_MAX)) {
+            // merge into the previous window
+            band[band_num - 1].y1 = y;
+        } else {
+            band[band_num].y0 = y0;
+            band[band_num].y1 = y;
+            band_num++;
+        }
+    }
+
+    memset(gram_dirty, 0x00, sizeof(gram_dirty));
+
+    return band_num;
+}
+
 LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     g->priv = gfxAlloc(GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 2);
     if (g->priv == NULL) {
@@ -56,6 +110,13 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
         *((uint8_t *)g->priv + i) = 0x00;
     }
 
+    gram_buff[0] = (uint8_t *)g->priv;
+    // without the second buffer it falls back to drawing into the one being sent
+    gram_buff[1] = gfxAlloc(GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 2);
+    if (gram_buff[1] != NULL) {
+        memset(gram_buff[1], 0x00, GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH * 2);
+    }
+
     // Initialise the board interface
     init_board(g);
 
@@ -156,6 +217,10 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     write_cmd(g, ST7735_RAMWR);     // 21: Set write ram, N args, no delay:
         write_buff(g, (uint8_t *)g->priv, GDISP_SCREEN_HEIGHT*GDISP_SCREEN_WIDTH*2);
     write_cmd(g, ST7735_DISPON);    // 22: Main screen turn on, no args, no delay
+#ifdef CONFIG_SCREEN_PANEL_TE_SYNC
+    write_cmd(g, ST7735_TEON);      // 23: Tearing effect line on, 1 arg, no delay:
+        write_data(g, 0x00);        //     V-blank only
+#endif
 
     /* Initialise the GDISP structure */
     g->g.Width  = GDISP_SCREEN_HEIGHT;
@@ -169,10 +234,27 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 
 #if GDISP_HARDWARE_FLUSH
     LLDSPEC void gdisp_lld_flush(GDisplay *g) {
+        gram_band_t band[GRAM_BANDS_MAX];
+        uint8_t band_num = 0;
         if (!(g->flags & GDISP_FLG_NEEDFLUSH)) {
             return;
         }
-        refresh_gram(g, (uint8_t *)g->priv);
+        band_num = gram_get_bands(band);
+        if (gram_buff[1]) {
+            uint8_t *front = (uint8_t *)g->priv;
+            // the other buffer is free again once its last transfer has finished
+            wait_gram(g);
+            g->priv = (front == gram_buff[0]) ? gram_buff[1] : gram_buff[0];
+            refresh_gram(g, front, band, band_num);
+            // the other buffer holds the previous frame, bring the changed rows up to this one
+            for (int i=0; i<band_num; i++) {
+                memcpy((uint8_t *)g->priv + band[i].y0 * GDISP_SCREEN_HEIGHT * 2,
+                       front + band[i].y0 * GDISP_SCREEN_HEIGHT * 2,
+                       (band[i].y1 - band[i].y0) * GDISP_SCREEN_HEIGHT * 2);
+            }
+        } else {
+            refresh_gram(g, (uint8_t *)g->priv, band, band_num);
+        }
         g->flags &= ~GDISP_FLG_NEEDFLUSH;
     }
 #endif
@@ -187,6 +269,7 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
         stream_write_cx = g->p.cx;
         stream_write_y  = g->p.y;
         stream_write_cy = g->p.cy;
+        gram_mark_dirty(g->p.y, g->p.cy);
     }
     LLDSPEC void gdisp_lld_write_color(GDisplay *g) {
         LLDCOLOR_TYPE c = gdispColor2Native(g->p.color);
@@ -212,6 +295,51 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     }
 #endif
 
+#if GDISP_HARDWARE_FILLS
+    LLDSPEC void gdisp_lld_fill_area(GDisplay *g) {
+        LLDCOLOR_TYPE c = gdispColor2Native(g->p.color);
+        // the GRAM holds the high byte first, swap once and store two pixels at a time
+        uint32_t c2 = (uint16_t)(c << 8 | c >> 8);
+        c2 |= c2 << 16;
+        uint16_t *row = (uint16_t *)g->priv + g->p.x + g->p.y * g->g.Width;
+        gram_mark_dirty(g->p.y, g->p.cy);
+        for (coord_t y=0; y<g->p.cy; y++) {
+            uint16_t *p = row;
+            coord_t cx = g->p.cx;
+            if (((uint32_t)p & 0x02) && cx > 0) {
+                *p++ = c2;
+                cx--;
+            }
+            uint32_t *p2 = (uint32_t *)p;
+            for (; cx>=2; cx-=2) {
+                *p2++ = c2;
+            }
+            if (cx > 0) {
+                *(uint16_t *)p2 = c2;
+            }
+            row += g->g.Width;
+        }
+        g->flags |= GDISP_FLG_NEEDFLUSH;
+    }
+#endif
+
+#if GDISP_HARDWARE_BITFILLS
+    LLDSPEC void gdisp_lld_blit_area(GDisplay *g) {
+        const pixel_t *src = (const pixel_t *)g->p.ptr + g->p.x1 + g->p.y1 * g->p.x2;
+        uint16_t *row = (uint16_t *)g->priv + g->p.x + g->p.y * g->g.Width;
+        gram_mark_dirty(g->p.y, g->p.cy);
+        for (coord_t y=0; y<g->p.cy; y++) {
+            for (coord_t x=0; x<g->p.cx; x++) {
+                LLDCOLOR_TYPE c = gdispColor2Native(src[x]);
+                row[x] = (uint16_t)(c << 8 | c >> 8);
+            }
+            src += g->p.x2;
+            row += g->g.Width;
+        }
+        g->flags |= GDISP_FLG_NEEDFLUSH;
+    }
+#endif
+
 #if GDISP_HARDWARE_STREAM_READ
     static int16_t stream_read_x  = 0;
     static int16_t stream_read_cx = 0;
@@ -287,6 +415,10 @@ LLDSPEC void gdisp_lld_control(GDisplay *g) {
         }
         g->g.Orientation = (orientation_t)g->p.ptr;
         return;
+    case GDISP_CONTROL_DIRTY_ROWS:
+        gram_mark_dirty(((coord_t *)g->p.ptr)[0], ((coord_t *)g->p.ptr)[1]);
+        g->flags |= GDISP_FLG_NEEDFLUSH;
+        return;
     case GDISP_CONTROL_BACKLIGHT:
         if ((unsigned)g->p.ptr > 255)
             g->p.ptr = (void *)255;
@@ -299,4 +431,16 @@ LLDSPEC void gdisp_lld_control(GDisplay *g) {
 }
 #endif
 
+#if GDISP_NEED_QUERY && GDISP_HARDWARE_QUERY
+LLDSPEC void *gdisp_lld_query(GDisplay *g) {
+    switch(g->p.x) {
+    case GDISP_QUERY_FRAMEBUFFER:
+        // the caller reports what it drew with GDISP_CONTROL_DIRTY_ROWS
+        return g->priv;
+    default:
+        return (void *)-1;
+    }
+}
+#endif
+
 #endif /* GFX_USE_GDISP */
@@ -10,12 +10,16 @@
 
 #include "board/st7735.h"
 
+#define GRAM_BANDS_MAX          ST7735_BANDS_MAX
+#define gram_band_t             st7735_band_t
+
 #define init_board(g)           st7735_init_board()
 #define set_backlight(g, val)   st7735_set_backlight(val)
 #define setpin_reset(g, val)    st7735_setpin_reset(val)
 #define write_cmd(g, cmd)       st7735_write_cmd(cmd)
 #define write_data(g, data)     st7735_write_data(data)
 #define write_buff(g, buff, n)  st7735_write_buff(buff, n)
-#define refresh_gram(g, gram)   st7735_refresh_gram(gram)
+#define refresh_gram(g, gram, band, band_num) st7735_refresh_gram(gram, band, band_num)
+#define wait_gram(g)            st7735_wait_gram()
 
 #endif /* _GDISP_LLD_BOARD_H */
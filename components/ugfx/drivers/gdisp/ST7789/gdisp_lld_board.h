@@ -10,12 +10,16 @@
 
 #include "board/st7789.h"
 
+#define GRAM_BANDS_MAX          ST7789_BANDS_MAX
+#define gram_band_t             st7789_band_t
+
 #define init_board(g)           st7789_init_board()
 #define set_backlight(g, val)   st7789_set_backlight(val)
 #define setpin_reset(g, val)    st7789_setpin_reset(val)
 #define write_cmd(g, cmd)       st7789_write_cmd(cmd)
 #define write_data(g, data)     st7789_write_data(data)
 #define write_buff(g, buff, n)  st7789_write_buff(buff, n)
-#define refresh_gram(g, gram)   st7789_refresh_gram(gram)
+#define refresh_gram(g, gram, band, band_num) st7789_refresh_gram(gram, band, band_num)
+#define wait_gram(g)            st7789_wait_gram()
 
 #endif /* _GDISP_LLD_BOARD_H */
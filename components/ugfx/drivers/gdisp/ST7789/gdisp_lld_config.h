@@ -17,7 +17,10 @@
 #define GDISP_HARDWARE_FLUSH            TRUE
 #define GDISP_HARDWARE_STREAM_WRITE     TRUE
 #define GDISP_HARDWARE_STREAM_READ      TRUE
+#define GDISP_HARDWARE_FILLS            TRUE
+#define GDISP_HARDWARE_BITFILLS         TRUE
 #define GDISP_HARDWARE_CONTROL          TRUE
+#define GDISP_HARDWARE_QUERY            TRUE
 
 #define GDISP_LLD_PIXELFORMAT           GDISP_PIXELFORMAT_RGB565
 
@@ -22,6 +22,8 @@
 #ifndef _GFXCONF_H
 #define _GFXCONF_H
 
+#include "sdkconfig.h"
+
 
 ///////////////////////////////////////////////////////////////////////////
 // GOS - One of these must be defined, preferably in your Makefile       //
@@ -70,11 +72,8 @@
 #define GFX_USE_GDISP                                TRUE
 
 // #define GDISP_NEED_AUTOFLUSH                         TRUE
-#ifdef CONFIG_VFX_OUTPUT_CUBE0414
-   #define GDISP_NEED_TIMERFLUSH                        8
-#else
-   #define GDISP_NEED_TIMERFLUSH                        16
-#endif
+// flushed by the vfx frame scheduler once per frame
+#define GDISP_NEED_TIMERFLUSH                        FALSE
 // #define GDISP_NEED_VALIDATION                        TRUE
 // #define GDISP_NEED_CLIP                              TRUE
 // #define GDISP_NEED_CIRCLE                            TRUE
@@ -86,7 +85,9 @@
 // #define GDISP_NEED_SCROLL                            TRUE
 // #define GDISP_NEED_PIXELREAD                         TRUE
 #define GDISP_NEED_CONTROL                           TRUE
-// #define GDISP_NEED_QUERY                             TRUE
+#define GDISP_NEED_QUERY                             TRUE
+   #define GDISP_QUERY_FRAMEBUFFER                  1000    // GDISP_CONTROL_LLD: raw framebuffer of the driver
+   #define GDISP_CONTROL_DIRTY_ROWS                 1001    // GDISP_CONTROL_LLD: {y, cy} rows drawn through the framebuffer
 #define GDISP_NEED_MULTITHREAD                       TRUE
 // #define GDISP_NEED_STREAMING                         TRUE
 // #define GDISP_NEED_TEXT                              TRUE
@@ -179,7 +180,12 @@
       // #define GDISP_HARDWARE_QUERY                 FALSE
       // #define GDISP_HARDWARE_CLIP                  FALSE
 
+      #ifdef CONFIG_VFX_OUTPUT_CUBE0414
       #define GDISP_PIXELFORMAT                     GDISP_PIXELFORMAT_RGB888
+      #else
+      // the panels' own format, colors reach the framebuffer without conversion
+      #define GDISP_PIXELFORMAT                     GDISP_PIXELFORMAT_RGB565
+      #endif
    #endif
 
 //#define GDISP_USE_GFXNET                             FALSE
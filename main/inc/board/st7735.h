@@ -15,15 +15,25 @@
 #define ST7735_SCREEN_WIDTH  80
 #define ST7735_SCREEN_HEIGHT 160
 
+// most row windows sent in one refresh
+#define ST7735_BANDS_MAX 4
+
+typedef struct {
+    uint16_t y0;    // first row
+    uint16_t y1;    // one past the last row
+} st7735_band_t;
+
 extern void st7735_init_board(void);
 
 extern void st7735_set_backlight(uint8_t val);
 extern void st7735_setpin_dc(spi_transaction_t *);
+extern void st7735_refresh_done(spi_transaction_t *);
 extern void st7735_setpin_reset(uint8_t val);
 
 extern void st7735_write_cmd(uint8_t cmd);
 extern void st7735_write_data(uint8_t data);
 extern void st7735_write_buff(uint8_t *buff, uint32_t n);
-extern void st7735_refresh_gram(uint8_t *gram);
+extern void st7735_refresh_gram(uint8_t *gram, const st7735_band_t *band, uint8_t band_num);
+extern void st7735_wait_gram(void);
 
 #endif /* INC_BOARD_ST7735_H_ */
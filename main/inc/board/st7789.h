@@ -15,15 +15,25 @@
 #define ST7789_SCREEN_WIDTH  135
 #define ST7789_SCREEN_HEIGHT 240
 
+// most row windows sent in one refresh
+#define ST7789_BANDS_MAX 4
+
+typedef struct {
+    uint16_t y0;    // first row
+    uint16_t y1;    // one past the last row
+} st7789_band_t;
+
 extern void st7789_init_board(void);
 
 extern void st7789_set_backlight(uint8_t val);
 extern void st7789_setpin_dc(spi_transaction_t *);
+extern void st7789_refresh_done(spi_transaction_t *);
 extern void st7789_setpin_reset(uint8_t val);
 
 extern void st7789_write_cmd(uint8_t cmd);
 extern void st7789_write_data(uint8_t data);
 extern void st7789_write_buff(uint8_t *buff, uint32_t n);
-extern void st7789_refresh_gram(uint8_t *gram);
+extern void st7789_refresh_gram(uint8_t *gram, const st7789_band_t *band, uint8_t band_num);
+extern void st7789_wait_gram(void);
 
 #endif /* INC_BOARD_ST7789_H_ */
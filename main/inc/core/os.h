@@ -21,7 +21,6 @@ typedef enum user_event_group_bits {
     BLE_GATTS_IDLE_BIT    = BIT5,
 
     VFX_RELOAD_BIT        = BIT6,
-    VFX_FFT_NULL_BIT      = BIT7,
 
     KEY_SCAN_RUN_BIT      = BIT8,
 
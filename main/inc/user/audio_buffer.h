@@ -0,0 +1,37 @@
+/*
+ * audio_buffer.h
+ *
+ *  Created on: 2026-10-17 10:12
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_AUDIO_BUFFER_H_
+#define INC_USER_AUDIO_BUFFER_H_
+
+#include <stdint.h>
+
+/*
+ * Single-producer / single-consumer lock-free ring buffer.
+ *
+ * The head index is only written by the producer and the tail index is only
+ * written by the consumer, so no lock is needed as long as there is exactly
+ * one task on each side. Both indices are free-running, the buffer size must
+ * be a power of two.
+ */
+typedef struct {
+    uint8_t *data;
+    uint32_t size;
+    uint32_t head;
+    uint32_t tail;
+} audio_buffer_t;
+
+extern void audio_buffer_init(audio_buffer_t *buf, uint8_t *data, uint32_t size);
+extern void audio_buffer_reset(audio_buffer_t *buf);
+
+extern uint32_t audio_buffer_get_fill(audio_buffer_t *buf);
+extern uint32_t audio_buffer_get_free(audio_buffer_t *buf);
+
+extern uint32_t audio_buffer_write(audio_buffer_t *buf, const uint8_t *data, uint32_t len);
+extern uint32_t audio_buffer_read(audio_buffer_t *buf, uint8_t *data, uint32_t len);
+
+#endif /* INC_USER_AUDIO_BUFFER_H_ */
@@ -0,0 +1,24 @@
+/*
+ * audio_drift.h
+ *
+ *  Created on: 2026-10-17 21:05
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_AUDIO_DRIFT_H_
+#define INC_USER_AUDIO_DRIFT_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t target;    // fill level to hold, in frames
+    float fill_avg;     // smoothed fill level, in frames
+    float integ;        // integral term, in ppm
+    float ppm;          // estimated source clock offset, positive if the source runs fast
+} audio_drift_t;
+
+extern void audio_drift_reset(audio_drift_t *drift, uint32_t target_frames);
+extern void audio_drift_prime(audio_drift_t *drift);
+extern float audio_drift_update(audio_drift_t *drift, uint32_t fill_frames);
+
+#endif /* INC_USER_AUDIO_DRIFT_H_ */
@@ -0,0 +1,47 @@
+/*
+ * audio_eq.h
+ *
+ *  Created on: 2026-10-17 14:20
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_AUDIO_EQ_H_
+#define INC_USER_AUDIO_EQ_H_
+
+#include <stdint.h>
+
+#define AUDIO_EQ_BANDS_MAX 10
+
+typedef enum {
+    AUDIO_EQ_TYPE_OFF        = 0x00,
+    AUDIO_EQ_TYPE_PEAK       = 0x01,
+    AUDIO_EQ_TYPE_LOW_SHELF  = 0x02,
+    AUDIO_EQ_TYPE_HIGH_SHELF = 0x03,
+    AUDIO_EQ_TYPE_HIGH_PASS  = 0x04,
+    AUDIO_EQ_TYPE_LOW_PASS   = 0x05,
+
+    AUDIO_EQ_TYPE_MAX,
+} audio_eq_type_t;
+
+typedef struct {
+    uint8_t  type;
+    uint16_t freq;      // center / corner frequency in Hz
+    int16_t  gain;      // 0.1 dB, ignored by HP/LP
+    uint16_t q;         // quality factor * 100
+} audio_eq_band_t;
+
+typedef struct {
+    audio_eq_band_t band[AUDIO_EQ_BANDS_MAX];
+} audio_eq_config_t;
+
+extern void audio_eq_set_conf(const audio_eq_config_t *cfg);
+extern const audio_eq_config_t *audio_eq_get_conf(void);
+
+extern void audio_eq_set_sample_rate(int rate);
+extern uint8_t audio_eq_get_band_count(void);
+
+extern void audio_eq_process(int16_t *data, uint32_t num_frames);
+
+extern void audio_eq_init(void);
+
+#endif /* INC_USER_AUDIO_EQ_H_ */
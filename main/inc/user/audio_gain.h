@@ -0,0 +1,23 @@
+/*
+ * audio_gain.h
+ *
+ *  Created on: 2026-10-17 13:05
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_AUDIO_GAIN_H_
+#define INC_USER_AUDIO_GAIN_H_
+
+#include <stdint.h>
+
+// AVRCP absolute volume range
+#define AUDIO_GAIN_VOLUME_MAX (0x7f)
+
+extern void audio_gain_set_volume(uint8_t volume);
+extern uint8_t audio_gain_get_volume(void);
+
+extern void audio_gain_process(int16_t *data, uint32_t num_frames);
+
+extern void audio_gain_init(void);
+
+#endif /* INC_USER_AUDIO_GAIN_H_ */
@@ -0,0 +1,28 @@
+/*
+ * audio_limiter.h
+ *
+ *  Created on: 2026-10-17 15:40
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_AUDIO_LIMITER_H_
+#define INC_USER_AUDIO_LIMITER_H_
+
+#include <stdint.h>
+
+/*
+ * Look-ahead window of the limiter. The output is delayed by
+ * AUDIO_LIMITER_LOOKAHEAD - 1 frames, about 1.4 ms at 44.1 kHz.
+ */
+#define AUDIO_LIMITER_LOOKAHEAD (64)
+
+extern void audio_limiter_set_sample_rate(int rate);
+
+extern void audio_limiter_process(int16_t *data, uint32_t num_frames);
+
+/* peak gain reduction since the last call, in 0.1 dB */
+extern uint16_t audio_limiter_get_reduction(void);
+
+extern void audio_limiter_init(void);
+
+#endif /* INC_USER_AUDIO_LIMITER_H_ */
@@ -0,0 +1,42 @@
+/*
+ * audio_output.h
+ *
+ *  Created on: 2026-10-17 10:26
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_AUDIO_OUTPUT_H_
+#define INC_USER_AUDIO_OUTPUT_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t size;          // ring buffer size in bytes
+    uint32_t fill;          // current fill level in bytes
+    uint32_t underruns;     // writer found the buffer empty while streaming
+    uint32_t overruns;      // packets dropped because the buffer was full
+    int32_t  drift_ppm;     // estimated source clock offset, positive if the source runs fast
+    uint32_t latency_ms;    // buffered audio including the limiter and the I2S DMA buffers
+    uint32_t sample_rate;   // current I2S output sample rate
+    uint32_t rate_changes;  // number of I2S sample rate switches
+} audio_output_stats_t;
+
+extern uint32_t audio_output_write(const uint8_t *data, uint32_t len);
+
+extern void audio_output_set_sample_rate(int rate);
+
+extern void audio_output_write_prompt(const uint8_t *data, uint32_t len);
+extern void audio_output_wait_prompt(uint32_t len);
+extern void audio_output_set_prompt_sample_rate(int rate);
+
+extern void audio_output_prompt_start(void);
+extern void audio_output_prompt_stop(void);
+
+extern void audio_output_start(void);
+extern void audio_output_stop(void);
+
+extern void audio_output_get_stats(audio_output_stats_t *stats);
+
+extern void audio_output_init(void);
+
+#endif /* INC_USER_AUDIO_OUTPUT_H_ */
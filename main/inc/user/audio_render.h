@@ -8,8 +8,10 @@
 #ifndef INC_USER_AUDIO_RENDER_H_
 #define INC_USER_AUDIO_RENDER_H_
 
-extern void render_sample_block_mono(short *short_sample_buff, int no_samples);
-extern void render_sample_block(short *sample_buff_ch0, short *sample_buff_ch1, int num_samples, unsigned int num_channels);
+struct mad_synth;
+struct mad_frame;
+
+extern void render_frame(struct mad_synth *synth, struct mad_frame const *frame);
 extern void set_dac_sample_rate(int rate);
 
 #endif /* INC_USER_AUDIO_RENDER_H_ */
@@ -9,9 +9,9 @@
 #define INC_USER_VFX_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "gfx.h"
-#include "fft.h"
 
 typedef enum {
     VFX_MODE_IDX_RANDOM = 0x00,
@@ -34,6 +34,7 @@ typedef enum {
     VFX_MODE_IDX_FOUNTAIN_S_L = 0x10,
     VFX_MODE_IDX_FOUNTAIN_G_L = 0x11,
     VFX_MODE_IDX_FOUNTAIN_H_L = 0x12,
+    VFX_MODE_IDX_FOUNTAIN_STEREO = 0x13,
 
     VFX_MODE_IDX_MAX,
 
@@ -48,7 +49,12 @@ typedef struct {
     uint8_t backlight;
 } vfx_config_t;
 
-#define FFT_N 128
+typedef struct {
+    bool (*init)(void);                                 // false: the effect can not start
+    bool (*render)(uint32_t frame, uint32_t dt);        // false: the effect has finished
+    void (*teardown)(void);
+    uint16_t period;                                    // frame period in ms
+} vfx_effect_t;
 
 #define DEFAULT_VFX_MODE VFX_MODE_IDX_FOUNTAIN_H_N
 #define DEFAULT_VFX_SCALE_FACTOR 0xFF
@@ -63,9 +69,6 @@ typedef struct {
 
 extern GDisplay *vfx_gdisp;
 
-extern float vfx_fft_input[FFT_N];
-extern float vfx_fft_output[FFT_N];
-
 #ifdef CONFIG_SCREEN_PANEL_OUTPUT_VFX
     #ifdef CONFIG_VFX_OUTPUT_ST7735
         // ani0.gif
@@ -0,0 +1,38 @@
+/*
+ * vfx_bar.h
+ *
+ *  Created on: 2026-10-17 20:10
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_VFX_BAR_H_
+#define INC_USER_VFX_BAR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "user/vfx_spectrum.h"
+
+#define VFX_BAR_CHANNELS (2)
+
+/* all rates are per displayed frame */
+typedef struct {
+    float attack;   // share of a rise applied per frame, 1.0 follows the input at once
+    float release;  // share of a fall applied per frame
+    float gravity;  // peak fall acceleration, in share of the bar range per frame^2
+    uint8_t hold;   // frames a peak stays before it starts to fall
+} vfx_bar_config_t;
+
+#define DEFAULT_VFX_BAR_ATTACK  0.7
+#define DEFAULT_VFX_BAR_RELEASE 0.15
+#define DEFAULT_VFX_BAR_GRAVITY 0.002
+#define DEFAULT_VFX_BAR_HOLD    20
+
+extern void vfx_bar_set_conf(const vfx_bar_config_t *cfg);
+/* resets the bars of all channels, NULL restores the default config */
+extern void vfx_bar_reset(uint16_t bar_num, const vfx_bar_config_t *cfg);
+
+/* converts val to dB if log_scale, scales it by gain into [min, max], then smooths and tracks the peaks, call once per frame */
+extern void vfx_bar_update(uint8_t ch, const float *val, bool log_scale, float gain, int16_t min, int16_t max, int16_t *out, int16_t *peak);
+
+#endif /* INC_USER_VFX_BAR_H_ */
@@ -0,0 +1,32 @@
+/*
+ * vfx_beat.h
+ *
+ *  Created on: 2026-10-17 19:05
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_VFX_BEAT_H_
+#define INC_USER_VFX_BEAT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// confidence above which bpm and phase follow the music
+#define VFX_BEAT_LOCKED (0.3f)
+
+typedef struct {
+    float bpm;              // tempo estimate, 60 to 180
+    float phase;            // position inside the current beat, 0.0 to 1.0
+    float confidence;       // normalised autocorrelation at the beat period, 0.0 to 1.0
+    uint32_t beat_count;    // incremented on every beat
+    bool onset;             // an onset was detected by the last update
+} vfx_beat_t;
+
+extern void vfx_beat_reset(void);
+/* feeds one analysed window, frames is the number of audio frames since the previous one */
+extern void vfx_beat_update(const float *amp, uint16_t bin_num, uint32_t frames, int rate);
+extern const vfx_beat_t *vfx_beat_get(void);
+
+extern void vfx_beat_init(void);
+
+#endif /* INC_USER_VFX_BEAT_H_ */
@@ -1,14 +0,0 @@
-/*
- * vfx_color_table.h
- *
- *  Created on: 2018-05-11 16:19
- *      Author: Jack Chen <redchenjs@live.com>
- */
-
-#ifndef INC_USER_VFX_COLOR_TABLE_H_
-#define INC_USER_VFX_COLOR_TABLE_H_
-
-extern const unsigned char vfx_color_table_256[];
-extern const unsigned char vfx_color_table_512[];
-
-#endif /* INC_USER_VFX_COLOR_TABLE_H_ */
@@ -10,12 +10,40 @@
 
 #include <stdint.h>
 
-extern uint32_t vfx_read_color_from_table(uint16_t color_idx, uint16_t color_ctr);
+extern uint32_t vfx_get_color(uint16_t color_idx, uint16_t color_ctr);
+
+#ifdef CONFIG_SCREEN_PANEL_OUTPUT_VFX
+extern uint16_t vfx_native_color(uint16_t color);
+extern uint16_t *vfx_get_framebuffer(void);
+extern void vfx_mark_dirty(int16_t y, int16_t cy);
+#endif
+
+#ifndef CONFIG_SCREEN_PANEL_OUTPUT_VFX
+#define VFX_CUBE_N 8
+
+// gdisp colors indexed [z][y][x], the same order as the 64x8 cube GRAM
+typedef uint32_t vfx_voxel_t[VFX_CUBE_N][VFX_CUBE_N][VFX_CUBE_N];
+
+typedef enum {
+    VFX_AXIS_X = 0x00,
+    VFX_AXIS_Y = 0x01,
+    VFX_AXIS_Z = 0x02,
+} vfx_axis_t;
+
+extern vfx_voxel_t vfx_voxel;
+
+extern void vfx_voxel_clear(void);
+extern void vfx_voxel_fill(uint8_t x, uint8_t y, uint8_t z, uint8_t cx, uint8_t cy, uint8_t cz, uint32_t color);
+extern void vfx_voxel_shift(vfx_axis_t axis, int8_t step);
+extern void vfx_voxel_copy_layer(vfx_axis_t axis, uint8_t src, uint8_t dst);
+extern void vfx_voxel_rotate(uint8_t turns);
+extern void vfx_voxel_blit_layer(vfx_axis_t axis, uint8_t layer, const uint8_t *bitmap, const uint32_t *color, uint8_t color_step);
+extern void vfx_voxel_present(void);
+#endif
 
 extern void vfx_draw_pixel(uint8_t x, uint8_t y, uint8_t z, uint16_t color_idx, uint16_t color_ctr);
 extern void vfx_fill_cube(uint8_t x, uint8_t y, uint8_t z, uint8_t cx, uint8_t cy, uint8_t cz, uint16_t color_idx, uint16_t color_ctr);
 extern void vfx_draw_cube_bitmap(const uint8_t *bitmap, uint16_t color_ctr);
-extern void vfx_draw_layer_bitmap(uint8_t layer, const uint8_t *bitmap, uint16_t color_ctr);
 extern void vfx_draw_layer_number(uint8_t num, uint8_t layer, uint16_t color_idx, uint16_t color_ctr);
 
 #endif /* INC_USER_VFX_CORE_H_ */
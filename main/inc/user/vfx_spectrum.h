@@ -0,0 +1,92 @@
+/*
+ * vfx_spectrum.h
+ *
+ *  Created on: 2026-10-17 16:20
+ *      Author: agent <agent@local>
+ */
+
+#ifndef INC_USER_VFX_SPECTRUM_H_
+#define INC_USER_VFX_SPECTRUM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VFX_SPECTRUM_SIZE_MIN  (256)
+#define VFX_SPECTRUM_SIZE_MAX  (1024)
+#define VFX_SPECTRUM_BINS_MAX  (VFX_SPECTRUM_SIZE_MAX / 2)
+#define VFX_SPECTRUM_BANDS_MAX (64)
+
+typedef enum {
+    VFX_SPECTRUM_WINDOW_HANN     = 0x00,
+    VFX_SPECTRUM_WINDOW_BLACKMAN = 0x01,
+
+    VFX_SPECTRUM_WINDOW_MAX,
+} vfx_spectrum_window_t;
+
+typedef enum {
+    VFX_SPECTRUM_SCALE_LINEAR = 0x00,
+    VFX_SPECTRUM_SCALE_LOG    = 0x01,
+    VFX_SPECTRUM_SCALE_MEL    = 0x02,
+    VFX_SPECTRUM_SCALE_OCTAVE = 0x03,
+
+    VFX_SPECTRUM_SCALE_MAX,
+} vfx_spectrum_scale_t;
+
+typedef enum {
+    VFX_SPECTRUM_CHANNEL_LEFT  = 0x00,
+    VFX_SPECTRUM_CHANNEL_RIGHT = 0x01,
+    VFX_SPECTRUM_CHANNEL_BOTH  = 0x02,
+} vfx_spectrum_channel_t;
+
+typedef struct {
+    uint16_t size;      // FFT size, 256, 512 or 1024, windows overlap by 50%
+    uint8_t  window;    // vfx_spectrum_window_t
+    uint8_t  scale;     // vfx_spectrum_scale_t, frequency scale of the bands
+} vfx_spectrum_config_t;
+
+typedef struct {
+    float amp[VFX_SPECTRUM_BINS_MAX];       // linear magnitude of each bin, left channel in stereo mode
+    float band_amp[VFX_SPECTRUM_BANDS_MAX]; // peak magnitude of each band
+    float amp_r[VFX_SPECTRUM_BINS_MAX];     // right channel, stereo mode only
+    float band_amp_r[VFX_SPECTRUM_BANDS_MAX];
+    uint16_t bin_num;
+    uint16_t band_num;
+    bool stereo;
+    uint32_t seq;                           // sequence number of the analysed window
+} vfx_spectrum_t;
+
+typedef struct {
+    uint32_t published;     // windows completed by the audio producer
+    uint32_t dropped;       // windows overwritten or skipped before the vfx task read them
+} vfx_spectrum_stats_t;
+
+#define DEFAULT_VFX_SPECTRUM_SIZE   512
+#define DEFAULT_VFX_SPECTRUM_WINDOW VFX_SPECTRUM_WINDOW_HANN
+#define DEFAULT_VFX_SPECTRUM_SCALE  VFX_SPECTRUM_SCALE_LOG
+
+/* audio producers, data holds 16-bit stereo frames, never blocks */
+extern void vfx_spectrum_write(const uint8_t *data, uint32_t len, vfx_spectrum_channel_t channel);
+extern void vfx_spectrum_clear(void);
+extern void vfx_spectrum_set_sample_rate(int rate);
+extern void vfx_spectrum_get_stats(vfx_spectrum_stats_t *stats);
+
+extern void vfx_spectrum_set_conf(vfx_spectrum_config_t *cfg);
+extern vfx_spectrum_config_t *vfx_spectrum_get_conf(void);
+
+/* resets the published arrays, maps the bins onto band_num bands and starts the audio feed */
+extern void vfx_spectrum_start(uint16_t band_num);
+/* same as above, but analyses the left and right channels separately */
+extern void vfx_spectrum_start_stereo(uint16_t band_num);
+extern void vfx_spectrum_stop(void);
+
+/* analyses the pending audio windows, returns false if there is none */
+extern bool vfx_spectrum_update(void);
+extern const vfx_spectrum_t *vfx_spectrum_get(void);
+
+/* converts the band magnitudes (or levels) to smoothed bar heights in [min, max], call once per frame */
+extern void vfx_spectrum_get_height(int16_t *out, int16_t *peak, bool log_scale, uint16_t height, uint16_t scale_factor, int16_t min, int16_t max);
+extern void vfx_spectrum_get_stereo_height(int16_t *out_l, int16_t *out_r, bool log_scale, uint16_t height, uint16_t scale_factor, int16_t min, int16_t max);
+
+extern void vfx_spectrum_init(void);
+
+#endif /* INC_USER_VFX_SPECTRUM_H_ */
@@ -19,6 +19,7 @@
 #include "user/bt_app.h"
 #include "user/ble_app.h"
 #include "user/audio_input.h"
+#include "user/audio_output.h"
 #include "user/audio_player.h"
 
 static void core_init(void)
@@ -49,6 +50,8 @@ static void board_init(void) {}
 
 static void user_init(void)
 {
+    audio_output_init();
+
 #ifdef CONFIG_ENABLE_VFX
     vfx_init();
 #endif
@@ -9,6 +9,9 @@
 
 #include "esp_log.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 
@@ -20,11 +23,15 @@
 #define TAG "cube0414"
 
 static spi_transaction_t hspi_trans[2];
+static SemaphoreHandle_t gram_done = NULL;
 
 void cube0414_init_board(void)
 {
     memset(hspi_trans, 0x00, sizeof(hspi_trans));
 
+    gram_done = xSemaphoreCreateBinary();
+    xSemaphoreGive(gram_done);
+
     gpio_set_direction(CONFIG_LIGHT_CUBE_DC_PIN, GPIO_MODE_OUTPUT);
     gpio_set_level(CONFIG_LIGHT_CUBE_DC_PIN, 0);
 
@@ -37,6 +44,19 @@ void cube0414_setpin_dc(spi_transaction_t *t)
     gpio_set_level(CONFIG_LIGHT_CUBE_DC_PIN, dc);
 }
 
+void cube0414_refresh_done(spi_transaction_t *t)
+{
+    BaseType_t task_woken = pdFALSE;
+
+    if (t == &hspi_trans[1]) {
+        xSemaphoreGiveFromISR(gram_done, &task_woken);
+    }
+
+    if (task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
 void cube0414_write_cmd(uint8_t cmd)
 {
     hspi_trans[0].length = 8;
@@ -66,6 +86,12 @@ void cube0414_write_buff(uint8_t *buff, uint32_t n)
 
 void cube0414_refresh_gram(uint8_t *gram)
 {
+    spi_transaction_t *t = NULL;
+
+    // the previous frame must be out before the transactions are reused
+    xSemaphoreTake(gram_done, portMAX_DELAY);
+    while (spi_device_get_trans_result(hspi, &t, 0) == ESP_OK);
+
     hspi_trans[0].length = 8,
     hspi_trans[0].tx_data[0] = 0xDA;    // Write Frame Data
     hspi_trans[0].user = (void*)0;
@@ -80,4 +106,10 @@ void cube0414_refresh_gram(uint8_t *gram)
         spi_device_queue_trans(hspi, &hspi_trans[x], portMAX_DELAY);
     }
 }
+
+void cube0414_wait_gram(void)
+{
+    xSemaphoreTake(gram_done, portMAX_DELAY);
+    xSemaphoreGive(gram_done);
+}
 #endif
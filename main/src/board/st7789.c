@@ -9,6 +9,9 @@
 
 #include "esp_log.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "driver/gpio.h"
 #include "driver/ledc.h"
 #include "driver/spi_master.h"
@@ -20,11 +23,48 @@
 
 #define TAG "st7789"
 
-static spi_transaction_t hspi_trans[2];
+#define ST7789_X_OFFSET 0x28
+#define ST7789_Y_OFFSET 0x35
+
+static spi_transaction_t hspi_trans[1];
+static spi_transaction_t gram_trans[ST7789_BANDS_MAX][6];
+static spi_transaction_t *gram_last = NULL;
+static SemaphoreHandle_t gram_done = NULL;
+
+#ifdef CONFIG_SCREEN_PANEL_TE_SYNC
+// one panel refresh at the slowest supported frame rate
+#define ST7789_TE_TIMEOUT_MS 25
+
+static SemaphoreHandle_t te_sync = NULL;
+
+static void IRAM_ATTR st7789_te_isr(void *arg)
+{
+    BaseType_t task_woken = pdFALSE;
+
+    xSemaphoreGiveFromISR(te_sync, &task_woken);
+
+    if (task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+#endif
 
 void st7789_init_board(void)
 {
     memset(hspi_trans, 0x00, sizeof(hspi_trans));
+    memset(gram_trans, 0x00, sizeof(gram_trans));
+
+    gram_done = xSemaphoreCreateBinary();
+    xSemaphoreGive(gram_done);
+
+#ifdef CONFIG_SCREEN_PANEL_TE_SYNC
+    te_sync = xSemaphoreCreateBinary();
+
+    gpio_set_direction(CONFIG_SCREEN_PANEL_TE_PIN, GPIO_MODE_INPUT);
+    gpio_set_intr_type(CONFIG_SCREEN_PANEL_TE_PIN, GPIO_INTR_POSEDGE);
+    gpio_install_isr_service(0);
+    gpio_isr_handler_add(CONFIG_SCREEN_PANEL_TE_PIN, st7789_te_isr, NULL);
+#endif
 
     gpio_set_direction(CONFIG_SCREEN_PANEL_DC_PIN,  GPIO_MODE_OUTPUT);
     gpio_set_direction(CONFIG_SCREEN_PANEL_RST_PIN, GPIO_MODE_OUTPUT);
@@ -52,7 +92,11 @@ void st7789_init_board(void)
 
     ledc_fade_func_install(0);
 
+#ifdef CONFIG_SCREEN_PANEL_TE_SYNC
+    ESP_LOGI(TAG, "initialized, bl: %d, dc: %d, rst: %d, te: %d", CONFIG_SCREEN_PANEL_BL_PIN, CONFIG_SCREEN_PANEL_DC_PIN, CONFIG_SCREEN_PANEL_RST_PIN, CONFIG_SCREEN_PANEL_TE_PIN);
+#else
     ESP_LOGI(TAG, "initialized, bl: %d, dc: %d, rst: %d", CONFIG_SCREEN_PANEL_BL_PIN, CONFIG_SCREEN_PANEL_DC_PIN, CONFIG_SCREEN_PANEL_RST_PIN);
+#endif
 }
 
 void st7789_set_backlight(uint8_t val)
@@ -67,6 +111,19 @@ void st7789_setpin_dc(spi_transaction_t *t)
     gpio_set_level(CONFIG_SCREEN_PANEL_DC_PIN, dc);
 }
 
+void st7789_refresh_done(spi_transaction_t *t)
+{
+    BaseType_t task_woken = pdFALSE;
+
+    if (t == gram_last) {
+        xSemaphoreGiveFromISR(gram_done, &task_woken);
+    }
+
+    if (task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
 void st7789_setpin_reset(uint8_t val)
 {
     gpio_set_level(CONFIG_SCREEN_PANEL_RST_PIN, val);
@@ -99,20 +156,69 @@ void st7789_write_buff(uint8_t *buff, uint32_t n)
     spi_device_transmit(hspi, &hspi_trans[0]);
 }
 
-void st7789_refresh_gram(uint8_t *gram)
+static void st7789_set_trans(spi_transaction_t *t, uint8_t dc, uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3, uint8_t len)
 {
-    hspi_trans[0].length = 8,
-    hspi_trans[0].tx_data[0] = 0x2C;    // Set Write RAM
-    hspi_trans[0].user = (void*)0;
-    hspi_trans[0].flags = SPI_TRANS_USE_TXDATA;
+    t->length = len * 8;
+    t->tx_data[0] = d0;
+    t->tx_data[1] = d1;
+    t->tx_data[2] = d2;
+    t->tx_data[3] = d3;
+    t->user = (void*)(int)dc;
+    t->flags = SPI_TRANS_USE_TXDATA;
+}
+
+void st7789_refresh_gram(uint8_t *gram, const st7789_band_t *band, uint8_t band_num)
+{
+    spi_transaction_t *t = NULL;
+
+    // the previous frame must be out before the transactions are reused
+    xSemaphoreTake(gram_done, portMAX_DELAY);
+    while (spi_device_get_trans_result(hspi, &t, 0) == ESP_OK);
+
+    if (band_num == 0) {
+        xSemaphoreGive(gram_done);
+        return;
+    }
 
-    hspi_trans[1].length = ST7789_SCREEN_WIDTH*ST7789_SCREEN_HEIGHT*2*8;
-    hspi_trans[1].tx_buffer = gram;
-    hspi_trans[1].user = (void*)1;
+    for (int i=0; i<band_num; i++) {
+        uint16_t x0 = ST7789_X_OFFSET;
+        uint16_t x1 = ST7789_X_OFFSET + ST7789_SCREEN_HEIGHT - 1;
+        uint16_t y0 = ST7789_Y_OFFSET + band[i].y0;
+        uint16_t y1 = ST7789_Y_OFFSET + band[i].y1 - 1;
+
+        t = gram_trans[i];
+
+        st7789_set_trans(&t[0], 0, 0x2A, 0, 0, 0, 1);                   // Set Column Address
+        st7789_set_trans(&t[1], 1, x0 >> 8, x0, x1 >> 8, x1, 4);
+        st7789_set_trans(&t[2], 0, 0x2B, 0, 0, 0, 1);                   // Set Row Address
+        st7789_set_trans(&t[3], 1, y0 >> 8, y0, y1 >> 8, y1, 4);
+        st7789_set_trans(&t[4], 0, 0x2C, 0, 0, 0, 1);                   // Set Write RAM
+
+        t[5].length = (band[i].y1 - band[i].y0) * ST7789_SCREEN_HEIGHT * 2 * 8;
+        t[5].tx_buffer = gram + band[i].y0 * ST7789_SCREEN_HEIGHT * 2;
+        t[5].user = (void*)1;
+        t[5].flags = 0;
+    }
+
+    gram_last = &gram_trans[band_num - 1][5];
+
+#ifdef CONFIG_SCREEN_PANEL_TE_SYNC
+    // start on a fresh V-blank so the panel scan never overtakes the write
+    xSemaphoreTake(te_sync, 0);
+    xSemaphoreTake(te_sync, ST7789_TE_TIMEOUT_MS / portTICK_RATE_MS);
+#endif
 
     // Queue all transactions.
-    for (int x=0; x<2; x++) {
-        spi_device_queue_trans(hspi, &hspi_trans[x], portMAX_DELAY);
+    for (int i=0; i<band_num; i++) {
+        for (int x=0; x<6; x++) {
+            spi_device_queue_trans(hspi, &gram_trans[i][x], portMAX_DELAY);
+        }
     }
 }
+
+void st7789_wait_gram(void)
+{
+    xSemaphoreTake(gram_done, portMAX_DELAY);
+    xSemaphoreGive(gram_done);
+}
 #endif
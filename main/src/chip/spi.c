@@ -43,14 +43,17 @@ void hspi_init(void)
         .clock_speed_hz = 40000000,               // Clock out at 40 MHz
         .queue_size = 2,                          // We want to be able to queue 2 transactions at a time
         .pre_cb = cube0414_setpin_dc,             // Specify pre-transfer callback to handle D/C line
+        .post_cb = cube0414_refresh_done,         // Specify post-transfer callback to release the GRAM
 #elif defined(CONFIG_VFX_OUTPUT_ST7735)
         .clock_speed_hz = 26000000,               // Clock out at 26 MHz
-        .queue_size = 6,                          // We want to be able to queue 6 transactions at a time
+        .queue_size = ST7735_BANDS_MAX * 6,       // We want to be able to queue a whole refresh at a time
         .pre_cb = st7735_setpin_dc,               // Specify pre-transfer callback to handle D/C line
+        .post_cb = st7735_refresh_done,           // Specify post-transfer callback to release the GRAM
 #elif defined(CONFIG_VFX_OUTPUT_ST7789)
         .clock_speed_hz = 40000000,               // Clock out at 40 MHz
-        .queue_size = 6,                          // We want to be able to queue 6 transactions at a time
+        .queue_size = ST7789_BANDS_MAX * 6,       // We want to be able to queue a whole refresh at a time
         .pre_cb = st7789_setpin_dc,               // Specify pre-transfer callback to handle D/C line
+        .post_cb = st7789_refresh_done,           // Specify post-transfer callback to release the GRAM
 #endif
         .flags = SPI_DEVICE_3WIRE | SPI_DEVICE_HALFDUPLEX
     };
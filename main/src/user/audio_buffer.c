@@ -0,0 +1,88 @@
+/*
+ * audio_buffer.c
+ *
+ *  Created on: 2026-10-17 10:12
+ *      Author: agent <agent@local>
+ */
+
+#include <string.h>
+
+#include "user/audio_buffer.h"
+
+void audio_buffer_init(audio_buffer_t *buf, uint8_t *data, uint32_t size)
+{
+    buf->data = data;
+    buf->size = size;
+    buf->head = 0;
+    buf->tail = 0;
+}
+
+/* only safe when neither side is running */
+void audio_buffer_reset(audio_buffer_t *buf)
+{
+    __atomic_store_n(&buf->head, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&buf->tail, 0, __ATOMIC_RELEASE);
+}
+
+uint32_t audio_buffer_get_fill(audio_buffer_t *buf)
+{
+    uint32_t head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+uint32_t audio_buffer_get_free(audio_buffer_t *buf)
+{
+    return buf->size - audio_buffer_get_fill(buf);
+}
+
+/* producer side, writes all or nothing */
+uint32_t audio_buffer_write(audio_buffer_t *buf, const uint8_t *data, uint32_t len)
+{
+    uint32_t head = buf->head;
+    uint32_t tail = __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE);
+
+    if (len > buf->size - (head - tail)) {
+        return 0;
+    }
+
+    uint32_t idx = head & (buf->size - 1);
+    uint32_t cnt = buf->size - idx;
+
+    if (cnt > len) {
+        cnt = len;
+    }
+
+    memcpy(buf->data + idx, data, cnt);
+    memcpy(buf->data, data + cnt, len - cnt);
+
+    __atomic_store_n(&buf->head, head + len, __ATOMIC_RELEASE);
+
+    return len;
+}
+
+/* consumer side, reads up to len bytes */
+uint32_t audio_buffer_read(audio_buffer_t *buf, uint8_t *data, uint32_t len)
+{
+    uint32_t tail = buf->tail;
+    uint32_t head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+
+    if (len > head - tail) {
+        len = head - tail;
+    }
+
+    uint32_t idx = tail & (buf->size - 1);
+    uint32_t cnt = buf->size - idx;
+
+    if (cnt > len) {
+        cnt = len;
+    }
+
+    memcpy(data, buf->data + idx, cnt);
+    memcpy(data + cnt, buf->data, len - cnt);
+
+    __atomic_store_n(&buf->tail, tail + len, __ATOMIC_RELEASE);
+
+    return len;
+}
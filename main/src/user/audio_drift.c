@@ -0,0 +1,51 @@
+/*
+ * audio_drift.c
+ *
+ *  Created on: 2026-10-17 21:05
+ *      Author: agent <agent@local>
+ */
+
+#include "user/audio_drift.h"
+
+// PI controller on the ring fill level, updated once per output chunk
+#define DRIFT_FILL_ALPHA (0.001f)   // fill level smoothing factor
+#define DRIFT_KP         (4000.0f)  // ppm per unit of relative fill error
+#define DRIFT_KI         (0.6f)     // ppm per chunk per unit of relative fill error
+#define DRIFT_MAX_PPM    (1000.0f)
+
+static float audio_drift_clamp(float ppm)
+{
+    if (ppm > DRIFT_MAX_PPM) {
+        return DRIFT_MAX_PPM;
+    } else if (ppm < -DRIFT_MAX_PPM) {
+        return -DRIFT_MAX_PPM;
+    }
+    return ppm;
+}
+
+/* a new stream may come from a different clock */
+void audio_drift_reset(audio_drift_t *drift, uint32_t target_frames)
+{
+    drift->target   = target_frames;
+    drift->fill_avg = target_frames;
+    drift->integ    = 0.0;
+    drift->ppm      = 0.0;
+}
+
+/* playback (re)starts with the ring primed to the target */
+void audio_drift_prime(audio_drift_t *drift)
+{
+    drift->fill_avg = drift->target;
+}
+
+float audio_drift_update(audio_drift_t *drift, uint32_t fill_frames)
+{
+    drift->fill_avg += ((float)fill_frames - drift->fill_avg) * DRIFT_FILL_ALPHA;
+
+    float err = (drift->fill_avg - drift->target) / drift->target;
+
+    drift->integ = audio_drift_clamp(drift->integ + DRIFT_KI * err);
+    drift->ppm   = audio_drift_clamp(DRIFT_KP * err + drift->integ);
+
+    return drift->ppm;
+}
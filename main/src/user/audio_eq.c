@@ -0,0 +1,351 @@
+/*
+ * audio_eq.c
+ *
+ *  Created on: 2026-10-17 14:20
+ *      Author: agent <agent@local>
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "core/app.h"
+#include "user/audio_eq.h"
+
+#define TAG "audio_eq"
+
+#define EQ_COEF_SHIFT  (28)     // Q28 coefficients, range +/-8.0
+#define EQ_DATA_SHIFT  (8)      // 8 extra fractional bits between the stages
+#define EQ_BLOCK_SIZE  (128)    // frames filtered per pass, longer calls are split
+#define EQ_GAIN_MAX    (150)    // +/-15 dB keeps the Q28 coefficients in range
+
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;
+} audio_eq_coef_t;
+
+typedef struct {
+    int32_t x1, x2, y1, y2;
+} audio_eq_state_t;
+
+typedef struct {
+    uint8_t num;
+    uint8_t slot[AUDIO_EQ_BANDS_MAX];
+    audio_eq_coef_t coef[AUDIO_EQ_BANDS_MAX];
+} audio_eq_coef_set_t;
+
+static audio_eq_config_t eq = {0};
+static uint32_t eq_rate = 44100;
+
+/* published under a seqlock, the writer task filters with its own copy and never waits */
+static audio_eq_coef_set_t coef_pub = {0};
+static audio_eq_coef_set_t coef_new = {0};
+static audio_eq_coef_set_t coef_cur = {0};
+static uint32_t coef_seq  = 0;
+static uint32_t coef_seen = 0;
+
+/* the set that was replaced, the next block is faded over from it */
+static audio_eq_coef_set_t coef_old = {0};
+static bool coef_fade = false;
+
+static audio_eq_state_t eq_state[AUDIO_EQ_BANDS_MAX][2] = {0};
+static audio_eq_state_t fade_state[AUDIO_EQ_BANDS_MAX][2] = {0};
+static int32_t eq_work[EQ_BLOCK_SIZE * 2] = {0};
+static int32_t eq_fade[EQ_BLOCK_SIZE * 2] = {0};
+
+static SemaphoreHandle_t eq_lock = NULL;
+
+static bool audio_eq_calc_coef(const audio_eq_band_t *band, uint32_t rate, audio_eq_coef_t *coef)
+{
+    float b0, b1, b2, a0, a1, a2;
+
+    float freq = band->freq;
+    if (freq < 10.0f) {
+        freq = 10.0f;
+    } else if (freq > rate * 0.45f) {
+        freq = rate * 0.45f;
+    }
+
+    float q = band->q / 100.0f;
+    if (q < 0.1f) {
+        q = 0.1f;
+    }
+
+    int16_t gain = band->gain;
+    if (gain > EQ_GAIN_MAX) {
+        gain = EQ_GAIN_MAX;
+    } else if (gain < -EQ_GAIN_MAX) {
+        gain = -EQ_GAIN_MAX;
+    }
+
+    float A     = powf(10.0f, gain / 400.0f);
+    float w0    = 2.0f * M_PI * freq / rate;
+    float cosw0 = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    float sqA   = 2.0f * sqrtf(A) * alpha;
+
+    // RBJ audio EQ cookbook
+    switch (band->type) {
+        case AUDIO_EQ_TYPE_PEAK:
+            b0 = 1.0f + alpha * A;
+            b1 = -2.0f * cosw0;
+            b2 = 1.0f - alpha * A;
+            a0 = 1.0f + alpha / A;
+            a1 = -2.0f * cosw0;
+            a2 = 1.0f - alpha / A;
+            break;
+        case AUDIO_EQ_TYPE_LOW_SHELF:
+            b0 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 + sqA);
+            b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw0);
+            b2 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 - sqA);
+            a0 = (A + 1.0f) + (A - 1.0f) * cosw0 + sqA;
+            a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw0);
+            a2 = (A + 1.0f) + (A - 1.0f) * cosw0 - sqA;
+            break;
+        case AUDIO_EQ_TYPE_HIGH_SHELF:
+            b0 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 + sqA);
+            b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0);
+            b2 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 - sqA);
+            a0 = (A + 1.0f) - (A - 1.0f) * cosw0 + sqA;
+            a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0);
+            a2 = (A + 1.0f) - (A - 1.0f) * cosw0 - sqA;
+            break;
+        case AUDIO_EQ_TYPE_HIGH_PASS:
+            b0 = (1.0f + cosw0) / 2.0f;
+            b1 = -(1.0f + cosw0);
+            b2 = (1.0f + cosw0) / 2.0f;
+            a0 = 1.0f + alpha;
+            a1 = -2.0f * cosw0;
+            a2 = 1.0f - alpha;
+            break;
+        case AUDIO_EQ_TYPE_LOW_PASS:
+            b0 = (1.0f - cosw0) / 2.0f;
+            b1 = 1.0f - cosw0;
+            b2 = (1.0f - cosw0) / 2.0f;
+            a0 = 1.0f + alpha;
+            a1 = -2.0f * cosw0;
+            a2 = 1.0f - alpha;
+            break;
+        default:
+            return false;
+    }
+
+    const float scale = (float)(1 << EQ_COEF_SHIFT) / a0;
+
+    coef->b0 = lroundf(b0 * scale);
+    coef->b1 = lroundf(b1 * scale);
+    coef->b2 = lroundf(b2 * scale);
+    coef->a1 = lroundf(a1 * scale);
+    coef->a2 = lroundf(a2 * scale);
+
+    return true;
+}
+
+/* computes a new coefficient set and publishes it, the filter itself never computes coefficients */
+static void audio_eq_update(void)
+{
+    audio_eq_coef_set_t set = {0};
+
+    for (int i = 0; i < AUDIO_EQ_BANDS_MAX; i++) {
+        if (audio_eq_calc_coef(&eq.band[i], eq_rate, &set.coef[set.num])) {
+            set.slot[set.num++] = i;
+        }
+    }
+
+    uint32_t seq = __atomic_load_n(&coef_seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&coef_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(&coef_pub, &set, sizeof(audio_eq_coef_set_t));
+
+    __atomic_store_n(&coef_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* picks up a newly published set, a torn copy is dropped and retried on the next block */
+static void audio_eq_fetch(void)
+{
+    uint32_t seq = __atomic_load_n(&coef_seq, __ATOMIC_ACQUIRE);
+
+    if (seq == coef_seen || (seq & 1)) {
+        return;
+    }
+
+    memcpy(&coef_new, &coef_pub, sizeof(audio_eq_coef_set_t));
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&coef_seq, __ATOMIC_RELAXED) != seq) {
+        return;
+    }
+
+    memcpy(&coef_old, &coef_cur, sizeof(audio_eq_coef_set_t));
+    memcpy(&coef_cur, &coef_new, sizeof(audio_eq_coef_set_t));
+    coef_seen = seq;
+    coef_fade = true;
+}
+
+static bool audio_eq_has_slot(const audio_eq_coef_set_t *set, uint8_t slot)
+{
+    for (uint8_t k = 0; k < set->num; k++) {
+        if (set->slot[k] == slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void audio_eq_run(const audio_eq_coef_set_t *set, audio_eq_state_t state[][2], int32_t *work, uint32_t num_frames)
+{
+    for (uint8_t k = 0; k < set->num; k++) {
+        const audio_eq_coef_t *c = &set->coef[k];
+
+        for (int ch = 0; ch < 2; ch++) {
+            audio_eq_state_t *s = &state[set->slot[k]][ch];
+            int32_t x1 = s->x1, x2 = s->x2, y1 = s->y1, y2 = s->y2;
+
+            for (uint32_t i = ch; i < num_frames * 2; i += 2) {
+                int32_t x0 = work[i];
+
+                int64_t acc = (int64_t)c->b0 * x0
+                            + (int64_t)c->b1 * x1
+                            + (int64_t)c->b2 * x2
+                            - (int64_t)c->a1 * y1
+                            - (int64_t)c->a2 * y2;
+
+                int32_t y0 = acc >> EQ_COEF_SHIFT;
+
+                x2 = x1;
+                x1 = x0;
+                y2 = y1;
+                y1 = y0;
+
+                work[i] = y0;
+            }
+
+            s->x1 = x1;
+            s->x2 = x2;
+            s->y1 = y1;
+            s->y2 = y2;
+        }
+    }
+}
+
+static void audio_eq_process_block(int16_t *data, uint32_t num_frames)
+{
+    const audio_eq_coef_set_t *set = &coef_cur;
+
+    if (set->num == 0 && !coef_fade) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < num_frames * 2; i++) {
+        eq_work[i] = data[i] << EQ_DATA_SHIFT;
+    }
+
+    if (coef_fade) {
+        // the old cascade runs once more on a copy of the state, its output is faded out below
+        memcpy(eq_fade, eq_work, num_frames * 2 * sizeof(int32_t));
+        memcpy(fade_state, eq_state, sizeof(eq_state));
+        audio_eq_run(&coef_old, fade_state, eq_fade, num_frames);
+
+        // a band that just came on starts from rest instead of from whatever it held when it went off
+        for (uint8_t k = 0; k < set->num; k++) {
+            if (!audio_eq_has_slot(&coef_old, set->slot[k])) {
+                memset(eq_state[set->slot[k]], 0x00, sizeof(eq_state[0]));
+            }
+        }
+    }
+
+    audio_eq_run(set, eq_state, eq_work, num_frames);
+
+    if (coef_fade) {
+        for (uint32_t i = 0; i < num_frames; i++) {
+            int64_t w = i + 1;
+
+            eq_work[i * 2]     = (eq_fade[i * 2]     * (num_frames - w) + eq_work[i * 2]     * w) / (int64_t)num_frames;
+            eq_work[i * 2 + 1] = (eq_fade[i * 2 + 1] * (num_frames - w) + eq_work[i * 2 + 1] * w) / (int64_t)num_frames;
+        }
+        coef_fade = false;
+    }
+
+    for (uint32_t i = 0; i < num_frames * 2; i++) {
+        int32_t y = (eq_work[i] + (1 << (EQ_DATA_SHIFT - 1))) >> EQ_DATA_SHIFT;
+
+        data[i] = (y > INT16_MAX) ? INT16_MAX : (y < INT16_MIN) ? INT16_MIN : y;
+    }
+}
+
+/* a coefficient change is crossfaded over the first block filtered with the new set */
+void audio_eq_process(int16_t *data, uint32_t num_frames)
+{
+    audio_eq_fetch();
+
+    while (num_frames) {
+        uint32_t n = (num_frames > EQ_BLOCK_SIZE) ? EQ_BLOCK_SIZE : num_frames;
+
+        audio_eq_process_block(data, n);
+
+        data += n * 2;
+        num_frames -= n;
+    }
+}
+
+void audio_eq_set_sample_rate(int rate)
+{
+    if ((uint32_t)rate == eq_rate) {
+        return;
+    }
+
+    xSemaphoreTake(eq_lock, portMAX_DELAY);
+
+    eq_rate = rate;
+    audio_eq_update();
+
+    xSemaphoreGive(eq_lock);
+}
+
+uint8_t audio_eq_get_band_count(void)
+{
+    return coef_cur.num;
+}
+
+/* callers stage changes in their own copy, the writer task may read the config at a rate change */
+void audio_eq_set_conf(const audio_eq_config_t *cfg)
+{
+    xSemaphoreTake(eq_lock, portMAX_DELAY);
+
+    if (cfg != &eq) {
+        memcpy(&eq, cfg, sizeof(audio_eq_config_t));
+    }
+    audio_eq_update();
+
+    xSemaphoreGive(eq_lock);
+
+    for (int i = 0; i < AUDIO_EQ_BANDS_MAX; i++) {
+        if (eq.band[i].type != AUDIO_EQ_TYPE_OFF) {
+            ESP_LOGI(TAG, "band %d: type: %u, freq: %u Hz, gain: %d.%d dB, q: %u.%02u", i,
+                     eq.band[i].type, eq.band[i].freq, eq.band[i].gain / 10, abs(eq.band[i].gain % 10),
+                     eq.band[i].q / 100, eq.band[i].q % 100);
+        }
+    }
+}
+
+const audio_eq_config_t *audio_eq_get_conf(void)
+{
+    return &eq;
+}
+
+void audio_eq_init(void)
+{
+    eq_lock = xSemaphoreCreateMutex();
+
+    size_t length = sizeof(audio_eq_config_t);
+    app_getenv("EQ_INIT_CFG", &eq, &length);
+
+    audio_eq_set_conf(&eq);
+}
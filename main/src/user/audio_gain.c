@@ -0,0 +1,100 @@
+/*
+ * audio_gain.c
+ *
+ *  Created on: 2026-10-17 13:05
+ *      Author: agent <agent@local>
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "user/audio_gain.h"
+
+#define TAG "audio_gain"
+
+#define GAIN_UNITY      (1 << 15)   // Q15
+#define GAIN_RAMP_SHIFT (8)         // ~6 ms time constant at 44.1 kHz
+#define GAIN_RANGE_DB   (60.0f)     // volume 1 maps to -60 dB, 0 mutes
+
+static int32_t gain_table[AUDIO_GAIN_VOLUME_MAX + 1] = {0};
+
+static uint8_t gain_volume = AUDIO_GAIN_VOLUME_MAX;
+static int32_t gain_target = GAIN_UNITY;
+// current gain in Q23 so that the exponential ramp settles exactly
+static int32_t gain_ramp   = GAIN_UNITY << 8;
+
+static uint32_t dither_seed = 22222;
+
+void audio_gain_set_volume(uint8_t volume)
+{
+    if (volume > AUDIO_GAIN_VOLUME_MAX) {
+        volume = AUDIO_GAIN_VOLUME_MAX;
+    }
+
+    gain_volume = volume;
+    gain_target = gain_table[volume];
+
+    ESP_LOGI(TAG, "volume: %u, gain: %d/%d", volume, gain_target, GAIN_UNITY);
+}
+
+uint8_t audio_gain_get_volume(void)
+{
+    return gain_volume;
+}
+
+/* applies the volume in place, with a per-frame ramp and TPDF dither on requantization */
+void audio_gain_process(int16_t *data, uint32_t num_frames)
+{
+    int32_t target = gain_target << 8;
+    int32_t ramp   = gain_ramp;
+
+    // settled at unity, nothing to requantize
+    if (ramp == target && target == (GAIN_UNITY << 8)) {
+        return;
+    }
+
+    // settled at mute, the dither alone would leave +/-1 LSB of noise
+    if (ramp == target && target == 0) {
+        memset(data, 0x00, num_frames * 2 * sizeof(int16_t));
+        return;
+    }
+
+    for (uint32_t i = 0; i < num_frames; i++) {
+        int32_t step = (target - ramp) / (1 << GAIN_RAMP_SHIFT);
+        if (step == 0) {
+            ramp = target;
+        } else {
+            ramp += step;
+        }
+
+        int32_t gain = ramp >> 8;
+
+        // two uniform 15-bit values from one LCG step, their difference is +/-1 LSB TPDF
+        dither_seed = dither_seed * 1664525 + 1013904223;
+        int32_t dither_l = (int32_t)(dither_seed & 0x7fff) - (int32_t)((dither_seed >> 16) & 0x7fff);
+        dither_seed = dither_seed * 1664525 + 1013904223;
+        int32_t dither_r = (int32_t)(dither_seed & 0x7fff) - (int32_t)((dither_seed >> 16) & 0x7fff);
+
+        int32_t l = (data[i * 2]     * gain + dither_l + (1 << 14)) >> 15;
+        int32_t r = (data[i * 2 + 1] * gain + dither_r + (1 << 14)) >> 15;
+
+        data[i * 2]     = (l > INT16_MAX) ? INT16_MAX : (l < INT16_MIN) ? INT16_MIN : l;
+        data[i * 2 + 1] = (r > INT16_MAX) ? INT16_MAX : (r < INT16_MIN) ? INT16_MIN : r;
+    }
+
+    gain_ramp = ramp;
+}
+
+void audio_gain_init(void)
+{
+    // logarithmic curve, evenly spaced in dB
+    gain_table[0] = 0;
+    for (int i = 1; i <= AUDIO_GAIN_VOLUME_MAX; i++) {
+        float db = (float)(i - AUDIO_GAIN_VOLUME_MAX) * GAIN_RANGE_DB / (AUDIO_GAIN_VOLUME_MAX - 1);
+        gain_table[i] = (int32_t)(GAIN_UNITY * powf(10.0f, db / 20.0f) + 0.5f);
+    }
+
+    gain_target = gain_table[gain_volume];
+}
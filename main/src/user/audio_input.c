@@ -5,8 +5,6 @@
  *      Author: Jack Chen <redchenjs@live.com>
  */
 
-#include <string.h>
-
 #include "esp_log.h"
 
 #include "freertos/FreeRTOS.h"
@@ -15,17 +13,20 @@
 #include "core/os.h"
 #include "core/app.h"
 #include "chip/i2s.h"
-#include "user/vfx.h"
+#include "user/vfx_spectrum.h"
 #include "user/audio_input.h"
 
 #define TAG "ain"
 
+// one DMA buffer worth of 16-bit stereo frames, see chip/i2s.c
+#define AUDIO_INPUT_CHUNK_FRAMES (128)
+
 static uint8_t ain_mode = DEFAULT_AIN_MODE;
 
 static void audio_input_task(void *pvParameters)
 {
     size_t bytes_read = 0;
-    char data[FFT_N * 4] = {0};
+    char data[AUDIO_INPUT_CHUNK_FRAMES * 4] = {0};
 
     ESP_LOGI(TAG, "started.");
 
@@ -38,47 +39,22 @@ static void audio_input_task(void *pvParameters)
             portMAX_DELAY
         );
 
-        i2s_read(CONFIG_AUDIO_INPUT_I2S_NUM, data, FFT_N * 4, &bytes_read, portMAX_DELAY);
+        i2s_read(CONFIG_AUDIO_INPUT_I2S_NUM, data, sizeof(data), &bytes_read, portMAX_DELAY);
 
 #ifdef CONFIG_ENABLE_VFX
         EventBits_t uxBits = xEventGroupGetBits(user_event_group);
-        if (!(uxBits & VFX_FFT_NULL_BIT)) {
+        if (!(uxBits & AUDIO_INPUT_RUN_BIT)) {
+            vfx_spectrum_clear();
             continue;
         }
 
-        // Copy data to FFT input buffer
-        uint32_t idx = 0;
-
 #ifdef CONFIG_AUDIO_INPUT_FFT_ONLY_LEFT
-        int16_t data_l = 0;
-        for (uint16_t k=0; k<FFT_N; k++,idx+=4) {
-            data_l = data[idx+1] << 8 | data[idx];
-
-            vfx_fft_input[k] = (float)data_l;
-        }
+        vfx_spectrum_write((uint8_t *)data, bytes_read, VFX_SPECTRUM_CHANNEL_LEFT);
 #elif defined(CONFIG_AUDIO_INPUT_FFT_ONLY_RIGHT)
-        int16_t data_r = 0;
-        for (uint16_t k=0; k<FFT_N; k++,idx+=4) {
-            data_r = data[idx+3] << 8 | data[idx+2];
-
-            vfx_fft_input[k] = (float)data_r;
-        }
+        vfx_spectrum_write((uint8_t *)data, bytes_read, VFX_SPECTRUM_CHANNEL_RIGHT);
 #else
-        int16_t data_l = 0, data_r = 0;
-        for (uint16_t k=0; k<FFT_N; k++,idx+=4) {
-            data_l = data[idx+1] << 8 | data[idx];
-            data_r = data[idx+3] << 8 | data[idx+2];
-
-            vfx_fft_input[k] = (float)((data_l + data_r) / 2);
-        }
+        vfx_spectrum_write((uint8_t *)data, bytes_read, VFX_SPECTRUM_CHANNEL_BOTH);
 #endif
-
-        uxBits = xEventGroupGetBits(user_event_group);
-        if (!(uxBits & AUDIO_INPUT_RUN_BIT)) {
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-        }
-
-        xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
 #endif // CONFIG_ENABLE_VFX
     }
 }
@@ -0,0 +1,208 @@
+/*
+ * audio_limiter.c
+ *
+ *  Created on: 2026-10-17 15:40
+ *      Author: agent <agent@local>
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+
+#include "user/audio_limiter.h"
+
+#define TAG "audio_limiter"
+
+#define GAIN_UNITY (1 << 15)    // Q15
+
+#define LIMITER_RELEASE_MS    (50)
+#define COMPRESSOR_ATTACK_MS  (5)
+#define COMPRESSOR_RELEASE_MS (100)
+
+static int32_t lim_ceiling   = 0;   // Q15 linear
+static int32_t lim_release   = 0;   // Q15 one-pole coefficient
+
+static int32_t comp_threshold = 0;  // log2 in Q16
+static int32_t comp_slope     = 0;  // 1 - 1 / ratio in Q16
+static int32_t comp_attack    = 0;  // Q15 one-pole coefficients
+static int32_t comp_release   = 0;
+static int32_t comp_env       = 0;  // Q15 linear
+
+// delay line holds the input and its compressor gain, the gain ring feeds the box filter
+static int16_t delay_data[AUDIO_LIMITER_LOOKAHEAD][2] = {0};
+static int32_t delay_gain[AUDIO_LIMITER_LOOKAHEAD] = {0};
+static int32_t box_gain[AUDIO_LIMITER_LOOKAHEAD] = {0};
+static int32_t box_sum  = 0;
+static int32_t rel_gain = GAIN_UNITY;
+static uint32_t pos = 0;
+
+// monotonic deque of the required gains in the window, increasing from head to tail
+static int32_t hold_gain[AUDIO_LIMITER_LOOKAHEAD] = {0};
+static uint32_t hold_frame[AUDIO_LIMITER_LOOKAHEAD] = {0};
+static uint32_t hold_head = 0;
+static uint32_t hold_tail = 0;
+static uint32_t frame_cnt = 0;
+
+static int32_t meter_gain = GAIN_UNITY;
+
+/* log2(x) in Q16, x > 0 */
+static inline int32_t audio_limiter_log2(uint32_t x)
+{
+    int32_t n = 31 - __builtin_clz(x);
+    int32_t f = ((x << (31 - n)) >> 15) & 0xffff;
+
+    // log2(1 + f) ~= f + 0.3431 * f * (1 - f)
+    return (n << 16) + f + ((((f * (0x10000 - f)) >> 16) * 22486) >> 16);
+}
+
+/* 2^(y / 65536) in Q15, y <= 0 */
+static inline int32_t audio_limiter_exp2(int32_t y)
+{
+    int32_t i = -(y >> 16);
+    int32_t f = y & 0xffff;
+
+    if (i > 15) {
+        return 0;
+    }
+
+    // 2^f ~= 1 + f - 0.3431 * f * (1 - f)
+    int32_t m = 0x10000 + f - ((((f * (0x10000 - f)) >> 16) * 22486) >> 16);
+
+    return (m >> 1) >> i;
+}
+
+static inline int32_t audio_limiter_coef(float ms, int rate)
+{
+    return lroundf(GAIN_UNITY * (1.0f - expf(-1000.0f / (ms * rate))));
+}
+
+void audio_limiter_set_sample_rate(int rate)
+{
+    lim_release  = audio_limiter_coef(LIMITER_RELEASE_MS, rate);
+    comp_attack  = audio_limiter_coef(COMPRESSOR_ATTACK_MS, rate);
+    comp_release = audio_limiter_coef(COMPRESSOR_RELEASE_MS, rate);
+}
+
+void audio_limiter_process(int16_t *data, uint32_t num_frames)
+{
+    int32_t block_gain = GAIN_UNITY;
+
+    for (uint32_t i = 0; i < num_frames; i++) {
+        int32_t l = data[i * 2];
+        int32_t r = data[i * 2 + 1];
+
+        // stereo-linked peak detection
+        int32_t peak = abs(l) > abs(r) ? abs(l) : abs(r);
+
+        // compressor, envelope follower on the peak and gain computer in the log domain
+        int32_t cg = GAIN_UNITY;
+        if (comp_slope) {
+            int32_t coef = peak > comp_env ? comp_attack : comp_release;
+            comp_env += ((peak - comp_env) * coef) >> 15;
+
+            int32_t over = audio_limiter_log2(comp_env + 1) - comp_threshold;
+            if (over > 0) {
+                cg = audio_limiter_exp2(-(int32_t)(((int64_t)over * comp_slope) >> 16));
+            }
+        }
+
+        // gain needed to keep the compressed peak under the ceiling
+        int32_t rg = GAIN_UNITY;
+        int32_t cpeak = (peak * cg) >> 15;
+        if (cpeak > lim_ceiling) {
+            rg = (lim_ceiling << 15) / cpeak;
+        }
+
+        delay_data[pos][0] = l;
+        delay_data[pos][1] = r;
+        delay_gain[pos] = cg;
+
+        // hold the minimum over the look-ahead window, then release exponentially
+        if (hold_head != hold_tail
+            && frame_cnt - hold_frame[hold_head % AUDIO_LIMITER_LOOKAHEAD] >= AUDIO_LIMITER_LOOKAHEAD) {
+            hold_head++;
+        }
+        while (hold_head != hold_tail && hold_gain[(hold_tail - 1) % AUDIO_LIMITER_LOOKAHEAD] >= rg) {
+            hold_tail--;
+        }
+        hold_gain[hold_tail % AUDIO_LIMITER_LOOKAHEAD] = rg;
+        hold_frame[hold_tail % AUDIO_LIMITER_LOOKAHEAD] = frame_cnt++;
+        hold_tail++;
+
+        int32_t hold = hold_gain[hold_head % AUDIO_LIMITER_LOOKAHEAD];
+
+        if (hold < rel_gain) {
+            rel_gain = hold;
+        } else {
+            // round up, a truncated step would stall the release 0.6 dB short of unity
+            rel_gain += ((hold - rel_gain) * lim_release + (1 << 15) - 1) >> 15;
+        }
+
+        // box filter over the window turns the hold into a smooth attack that completes before the peak
+        box_sum += rel_gain - box_gain[pos];
+        box_gain[pos] = rel_gain;
+
+        pos = (pos + 1) % AUDIO_LIMITER_LOOKAHEAD;
+
+        // oldest frame in the window
+        int32_t g = ((box_sum / AUDIO_LIMITER_LOOKAHEAD) * delay_gain[pos]) >> 15;
+
+        l = (delay_data[pos][0] * g) >> 15;
+        r = (delay_data[pos][1] * g) >> 15;
+
+        data[i * 2]     = (l > INT16_MAX) ? INT16_MAX : (l < INT16_MIN) ? INT16_MIN : l;
+        data[i * 2 + 1] = (r > INT16_MAX) ? INT16_MAX : (r < INT16_MIN) ? INT16_MIN : r;
+
+        if (g < block_gain) {
+            block_gain = g;
+        }
+    }
+
+    // peak-hold meter, reset by the reader
+    int32_t meter = __atomic_load_n(&meter_gain, __ATOMIC_RELAXED);
+    while (block_gain < meter
+           && !__atomic_compare_exchange_n(&meter_gain, &meter, block_gain, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+uint16_t audio_limiter_get_reduction(void)
+{
+    int32_t gain = __atomic_exchange_n(&meter_gain, GAIN_UNITY, __ATOMIC_RELAXED);
+
+    if (gain <= 0) {
+        return UINT16_MAX;
+    }
+
+    // 20 * log10(2) = 6.0206 dB per octave
+    int32_t db = ((int64_t)(audio_limiter_log2(GAIN_UNITY) - audio_limiter_log2(gain)) * 60206 / 1000) >> 16;
+
+    return db;
+}
+
+void audio_limiter_init(void)
+{
+    lim_ceiling = lroundf(GAIN_UNITY * powf(10.0f, -CONFIG_AUDIO_LIMITER_CEILING / 20.0f));
+
+    comp_threshold = audio_limiter_log2(lroundf(GAIN_UNITY * powf(10.0f, -CONFIG_AUDIO_COMPRESSOR_THRESHOLD / 20.0f)));
+    comp_slope = lroundf(65536.0f * (1.0f - 1.0f / CONFIG_AUDIO_COMPRESSOR_RATIO));
+
+    for (int k = 0; k < AUDIO_LIMITER_LOOKAHEAD; k++) {
+        delay_data[k][0] = 0;
+        delay_data[k][1] = 0;
+        delay_gain[k] = GAIN_UNITY;
+        box_gain[k] = GAIN_UNITY;
+    }
+    box_sum  = GAIN_UNITY * AUDIO_LIMITER_LOOKAHEAD;
+    rel_gain = GAIN_UNITY;
+    comp_env = 0;
+    pos = 0;
+
+    hold_head = hold_tail = 0;
+
+    audio_limiter_set_sample_rate(44100);
+
+    ESP_LOGI(TAG, "ceiling: -%d dBFS, compressor: -%d dBFS %d:1, look-ahead: %d frames",
+             CONFIG_AUDIO_LIMITER_CEILING, CONFIG_AUDIO_COMPRESSOR_THRESHOLD,
+             CONFIG_AUDIO_COMPRESSOR_RATIO, AUDIO_LIMITER_LOOKAHEAD);
+}
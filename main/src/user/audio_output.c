@@ -0,0 +1,529 @@
+/*
+ * audio_output.c
+ *
+ *  Created on: 2026-10-17 10:26
+ *      Author: agent <agent@local>
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/i2s.h"
+
+#include "chip/i2s.h"
+#include "user/audio_eq.h"
+#include "user/audio_gain.h"
+#include "user/audio_drift.h"
+#include "user/audio_limiter.h"
+#include "user/audio_buffer.h"
+#include "user/audio_output.h"
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+#include "xtensa/hal.h"
+#endif
+
+#define TAG "aout"
+
+// one DMA buffer worth of 16-bit stereo frames
+#define AUDIO_OUTPUT_CHUNK_FRAMES (128)
+// frames queued in the I2S DMA buffers, see chip/i2s.c
+#define AUDIO_OUTPUT_DMA_FRAMES   (8 * 128)
+// frames delayed by the processing stages
+#ifdef CONFIG_ENABLE_AUDIO_LIMITER
+    #define AUDIO_OUTPUT_PROC_FRAMES (AUDIO_LIMITER_LOOKAHEAD - 1)
+#else
+    #define AUDIO_OUTPUT_PROC_FRAMES (0)
+#endif
+
+// prompt mixer
+#define PROMPT_BUFFER_SIZE  (8192)
+#define PROMPT_PRIME_FRAMES (1152)  // one decoded MP3 frame
+#define PROMPT_DUCK_GAIN    (8192)  // -12 dB in Q15
+#define PROMPT_DUCK_STEP    (64)    // per frame, ~10 ms ramp at 44.1 kHz
+
+/* ring buffer reader with a linear fractional resampler */
+typedef struct {
+    audio_buffer_t ring;
+    int16_t  data[AUDIO_OUTPUT_CHUNK_FRAMES * 2];
+    uint32_t pos;
+    uint32_t len;
+    // interpolation between x0 and x1, phase is the Q32 position
+    int16_t  x0[2];
+    int16_t  x1[2];
+    uint32_t phase;
+} audio_output_src_t;
+
+static uint8_t stream_data[CONFIG_AUDIO_OUTPUT_BUFFER_SIZE];
+static uint8_t prompt_data[PROMPT_BUFFER_SIZE];
+
+static audio_output_src_t stream;
+static audio_output_src_t prompt;
+
+static TaskHandle_t writer_task = NULL;
+
+static uint8_t  stream_active = 0;
+static uint32_t stream_rate   = 0;
+// set from the BT callback, the writer adopts it at the next chunk boundary
+static volatile uint32_t stream_rate_req = 44100;
+static uint32_t output_rate   = 44100;
+static uint32_t target_frames = 0;
+static uint32_t underrun_cnt  = 0;
+static uint32_t overrun_cnt   = 0;
+static uint32_t rate_change_cnt = 0;
+
+static audio_drift_t drift;
+
+static uint8_t  prompt_active = 0;
+static uint32_t prompt_rate   = 44100;
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+#define BENCH_BLOCKS (1024)
+
+static uint32_t bench_blocks = 0;
+static uint32_t bench_gain   = 0;
+static uint32_t bench_eq     = 0;
+static uint32_t bench_lim    = 0;
+
+static void audio_output_bench_report(void)
+{
+    // cycles available per block at the current rate
+    uint32_t budget = (uint64_t)CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ * 1000000 * AUDIO_OUTPUT_CHUNK_FRAMES / output_rate;
+
+    ESP_LOGI(TAG, "avg cycles/block (%u frames @ %u Hz, budget %u): gain %u, eq %u (%u bands), limiter %u",
+             AUDIO_OUTPUT_CHUNK_FRAMES, output_rate, budget,
+             bench_gain / BENCH_BLOCKS, bench_eq / BENCH_BLOCKS, audio_eq_get_band_count(),
+             bench_lim / BENCH_BLOCKS);
+
+    bench_blocks = 0;
+    bench_gain   = 0;
+    bench_eq     = 0;
+    bench_lim    = 0;
+}
+#endif
+
+static bool audio_output_src_fetch(audio_output_src_t *src, int16_t *frame)
+{
+    if (src->pos == src->len) {
+        src->len = audio_buffer_read(&src->ring, (uint8_t *)src->data, sizeof(src->data)) / 4;
+        src->pos = 0;
+        if (src->len == 0) {
+            return false;
+        }
+    }
+
+    frame[0] = src->data[src->pos * 2];
+    frame[1] = src->data[src->pos * 2 + 1];
+    src->pos++;
+
+    return true;
+}
+
+static uint32_t audio_output_src_get_fill(audio_output_src_t *src)
+{
+    return audio_buffer_get_fill(&src->ring) / 4 + (src->len - src->pos);
+}
+
+static void audio_output_src_prime(audio_output_src_t *src)
+{
+    audio_output_src_fetch(src, src->x0);
+    audio_output_src_fetch(src, src->x1);
+    src->phase = 0;
+}
+
+/* returns the number of frames rendered, less than num_frames if the source ran dry */
+static uint32_t audio_output_src_render(audio_output_src_t *src, int16_t *out, uint32_t num_frames, int64_t step)
+{
+    for (uint32_t n = 0; n < num_frames; n++) {
+        int32_t frac = src->phase >> 17;
+
+        out[n * 2]     = src->x0[0] + (((src->x1[0] - src->x0[0]) * frac) >> 15);
+        out[n * 2 + 1] = src->x0[1] + (((src->x1[1] - src->x0[1]) * frac) >> 15);
+
+        uint64_t pos = src->phase + step;
+        src->phase = (uint32_t)pos;
+
+        for (uint32_t adv = pos >> 32; adv > 0; adv--) {
+            src->x0[0] = src->x1[0];
+            src->x0[1] = src->x1[1];
+            if (!audio_output_src_fetch(src, src->x1)) {
+                return n + 1;
+            }
+        }
+    }
+
+    return num_frames;
+}
+
+static inline int16_t audio_output_saturate(int32_t sample)
+{
+    if (sample > INT16_MAX) {
+        return INT16_MAX;
+    } else if (sample < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return sample;
+}
+
+static void audio_output_fade(int16_t *data, uint32_t num_frames, bool fade_in)
+{
+    for (uint32_t i = 0; i < num_frames; i++) {
+        int32_t gain = fade_in ? i : num_frames - i;
+
+        data[i * 2]     = data[i * 2]     * gain / (int32_t)num_frames;
+        data[i * 2 + 1] = data[i * 2 + 1] * gain / (int32_t)num_frames;
+    }
+}
+
+/* the stream rate wins while a stream is active, otherwise a prompt plays at its own rate */
+static uint32_t audio_output_get_desired_rate(uint8_t stream_running, uint8_t prompt_running)
+{
+    if (stream_active || stream_running) {
+        return stream_rate;
+    } else if (prompt_running) {
+        return prompt_rate;
+    }
+    return output_rate;
+}
+
+/* runs on the writer task only, it owns the drift controller */
+static void audio_output_apply_stream_rate(uint32_t rate)
+{
+    stream_rate = rate;
+
+    // keep at least half of the ring as headroom for packet bursts
+    target_frames = stream_rate * CONFIG_AUDIO_OUTPUT_TARGET_LATENCY / 1000;
+    if (target_frames > stream.ring.size / 4 / 2) {
+        target_frames = stream.ring.size / 4 / 2;
+    }
+
+    audio_drift_reset(&drift, target_frames);
+}
+
+static void audio_output_apply_rate(uint32_t rate)
+{
+    output_rate = rate;
+    rate_change_cnt++;
+
+    audio_eq_set_sample_rate(rate);
+#ifdef CONFIG_ENABLE_AUDIO_LIMITER
+    audio_limiter_set_sample_rate(rate);
+#endif
+
+    i2s_output_set_sample_rate(rate);
+
+    ESP_LOGI(TAG, "sample rate: %u", rate);
+}
+
+static void audio_output_task(void *pvParameters)
+{
+    uint8_t stream_running = 0;
+    uint8_t prompt_running = 0;
+    uint8_t fade_in = 0;
+    uint32_t last_n = 0;
+    int32_t duck_gain = 32768;
+    size_t bytes_written = 0;
+    int16_t out_data[AUDIO_OUTPUT_CHUNK_FRAMES * 2] = {0};
+    int16_t mix_data[AUDIO_OUTPUT_CHUNK_FRAMES * 2] = {0};
+
+    ESP_LOGI(TAG, "started.");
+
+    while (1) {
+        uint32_t n = 0;
+        uint32_t rate_req = stream_rate_req;
+
+        if (rate_req != stream_rate) {
+            audio_output_apply_stream_rate(rate_req);
+        }
+
+        // prime the stream to the target latency, a stopped stream is drained as is
+        if (!stream_running) {
+            uint32_t fill = audio_output_src_get_fill(&stream);
+            if (fill > 0 && (!stream_active || fill >= target_frames)) {
+                audio_output_src_prime(&stream);
+                audio_drift_prime(&drift);
+                stream_running = 1;
+            }
+        }
+
+        // start mixing a prompt once one decoded frame is buffered
+        if (!prompt_running) {
+            uint32_t fill = audio_output_src_get_fill(&prompt);
+            if (fill > 0 && (!prompt_active || fill >= PROMPT_PRIME_FRAMES)) {
+                audio_output_src_prime(&prompt);
+                prompt_running = 1;
+            }
+        }
+
+        // rate changes are applied at a chunk boundary, immediately if the output is silent
+        uint32_t new_rate = audio_output_get_desired_rate(stream_running, prompt_running);
+        if (new_rate != output_rate && last_n == 0) {
+            audio_output_apply_rate(new_rate);
+            fade_in = 1;
+        }
+
+        if (stream_running) {
+            // consume slightly more input frames per output frame when the source runs fast
+            int64_t step = ((uint64_t)stream_rate << 32) / output_rate + (int64_t)(drift.ppm * 4294.967296f);
+
+            n = audio_output_src_render(&stream, out_data, AUDIO_OUTPUT_CHUNK_FRAMES, step);
+            if (n < AUDIO_OUTPUT_CHUNK_FRAMES) {
+                if (stream_active) {
+                    underrun_cnt++;
+                }
+                stream_running = 0;
+            } else if (stream_active) {
+                audio_drift_update(&drift, audio_output_src_get_fill(&stream));
+            }
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+            uint32_t start = xthal_get_ccount();
+#endif
+
+            audio_gain_process(out_data, n);
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+            bench_gain += xthal_get_ccount() - start;
+#endif
+        }
+
+        if (prompt_running) {
+            int64_t step = ((uint64_t)prompt_rate << 32) / output_rate;
+
+            uint32_t m = audio_output_src_render(&prompt, mix_data, AUDIO_OUTPUT_CHUNK_FRAMES, step);
+            if (m < AUDIO_OUTPUT_CHUNK_FRAMES) {
+                prompt_running = 0;
+            }
+
+            // pad a short stream chunk with silence so the prompt keeps playing
+            for (; n < m; n++) {
+                out_data[n * 2]     = 0;
+                out_data[n * 2 + 1] = 0;
+            }
+
+            for (uint32_t i = 0; i < n; i++) {
+                if (duck_gain > PROMPT_DUCK_GAIN) {
+                    duck_gain -= PROMPT_DUCK_STEP;
+                }
+
+                int32_t l = (out_data[i * 2]     * duck_gain) >> 15;
+                int32_t r = (out_data[i * 2 + 1] * duck_gain) >> 15;
+
+                if (i < m) {
+                    l += mix_data[i * 2];
+                    r += mix_data[i * 2 + 1];
+                }
+
+                out_data[i * 2]     = audio_output_saturate(l);
+                out_data[i * 2 + 1] = audio_output_saturate(r);
+            }
+        } else if (duck_gain < 32768) {
+            // release the ducking after the prompt
+            for (uint32_t i = 0; i < n; i++) {
+                if (duck_gain < 32768) {
+                    duck_gain += PROMPT_DUCK_STEP;
+                }
+
+                out_data[i * 2]     = (out_data[i * 2]     * duck_gain) >> 15;
+                out_data[i * 2 + 1] = (out_data[i * 2 + 1] * duck_gain) >> 15;
+            }
+        }
+
+        last_n = n;
+
+        if (n == 0) {
+            if (new_rate == output_rate) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            continue;
+        }
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+        uint32_t start = xthal_get_ccount();
+#endif
+
+        audio_eq_process(out_data, n);
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+        bench_eq += xthal_get_ccount() - start;
+#endif
+
+#ifdef CONFIG_ENABLE_AUDIO_LIMITER
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+        start = xthal_get_ccount();
+#endif
+
+        audio_limiter_process(out_data, n);
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+        bench_lim += xthal_get_ccount() - start;
+#endif
+#endif
+
+#ifdef CONFIG_AUDIO_OUTPUT_BENCHMARK
+        if (++bench_blocks == BENCH_BLOCKS) {
+            audio_output_bench_report();
+        }
+#endif
+
+        if (fade_in) {
+            audio_output_fade(out_data, n, true);
+            fade_in = 0;
+        }
+
+        if (new_rate != output_rate) {
+            // fade out and push the faded chunk through the DMA buffers before switching
+            audio_output_fade(out_data, n, false);
+            i2s_write(CONFIG_AUDIO_OUTPUT_I2S_NUM, out_data, n * 4, &bytes_written, portMAX_DELAY);
+
+            memset(out_data, 0x00, sizeof(out_data));
+            for (int i = 0; i < AUDIO_OUTPUT_DMA_FRAMES / AUDIO_OUTPUT_CHUNK_FRAMES; i++) {
+                i2s_write(CONFIG_AUDIO_OUTPUT_I2S_NUM, out_data, sizeof(out_data), &bytes_written, portMAX_DELAY);
+            }
+
+            audio_output_apply_rate(new_rate);
+            fade_in = 1;
+            last_n = 0;
+            continue;
+        }
+
+        i2s_write(CONFIG_AUDIO_OUTPUT_I2S_NUM, out_data, n * 4, &bytes_written, portMAX_DELAY);
+    }
+}
+
+/* called from the A2DP sink data callback, never blocks */
+uint32_t audio_output_write(const uint8_t *data, uint32_t len)
+{
+    // keep the ring aligned to whole stereo frames
+    len &= ~0x03;
+
+    if (audio_buffer_write(&stream.ring, data, len) != len) {
+        overrun_cnt++;
+        return 0;
+    }
+
+    xTaskNotifyGive(writer_task);
+
+    return len;
+}
+
+/* called from the prompt player, blocks until all data is queued */
+void audio_output_write_prompt(const uint8_t *data, uint32_t len)
+{
+    len &= ~0x03;
+
+    while (len) {
+        uint32_t chunk = audio_buffer_get_free(&prompt.ring) & ~0x03;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        if (chunk == 0) {
+            xTaskNotifyGive(writer_task);
+            vTaskDelay(5 / portTICK_RATE_MS);
+            continue;
+        }
+
+        audio_buffer_write(&prompt.ring, data, chunk);
+
+        data += chunk;
+        len  -= chunk;
+    }
+
+    xTaskNotifyGive(writer_task);
+}
+
+/* blocks until len bytes fit in the prompt buffer */
+void audio_output_wait_prompt(uint32_t len)
+{
+    len &= ~0x03;
+    if (len > sizeof(prompt_data)) {
+        len = sizeof(prompt_data);
+    }
+
+    while (audio_buffer_get_free(&prompt.ring) < len) {
+        xTaskNotifyGive(writer_task);
+        vTaskDelay(5 / portTICK_RATE_MS);
+    }
+}
+
+void audio_output_set_prompt_sample_rate(int rate)
+{
+    prompt_rate = rate;
+}
+
+void audio_output_prompt_start(void)
+{
+    prompt_active = 1;
+}
+
+/* blocks until the queued prompt has been played */
+void audio_output_prompt_stop(void)
+{
+    prompt_active = 0;
+
+    xTaskNotifyGive(writer_task);
+
+    while (audio_output_src_get_fill(&prompt) != 0) {
+        vTaskDelay(5 / portTICK_RATE_MS);
+    }
+}
+
+/* called on ESP_A2D_AUDIO_CFG_EVT, the writer switches the output rate at the next chunk boundary */
+void audio_output_set_sample_rate(int rate)
+{
+    stream_rate_req = rate;
+
+    xTaskNotifyGive(writer_task);
+}
+
+void audio_output_start(void)
+{
+    stream_active = 1;
+
+    xTaskNotifyGive(writer_task);
+}
+
+void audio_output_stop(void)
+{
+    stream_active = 0;
+
+    xTaskNotifyGive(writer_task);
+
+    audio_output_stats_t stats;
+    audio_output_get_stats(&stats);
+
+    ESP_LOGI(TAG, "fill: %u/%u, underruns: %u, overruns: %u, drift: %d ppm, latency: %u ms, rate changes: %u",
+             stats.fill, stats.size, stats.underruns, stats.overruns, stats.drift_ppm, stats.latency_ms, stats.rate_changes);
+}
+
+void audio_output_get_stats(audio_output_stats_t *stats)
+{
+    uint32_t fill = audio_buffer_get_fill(&stream.ring);
+
+    stats->size = stream.ring.size;
+    stats->fill = fill;
+    stats->underruns = underrun_cnt;
+    stats->overruns = overrun_cnt;
+    stats->drift_ppm = (int32_t)drift.ppm;
+    stats->latency_ms = (fill / 4 + AUDIO_OUTPUT_DMA_FRAMES + AUDIO_OUTPUT_PROC_FRAMES) * 1000 / output_rate;
+    stats->sample_rate = output_rate;
+    stats->rate_changes = rate_change_cnt;
+}
+
+void audio_output_init(void)
+{
+    audio_buffer_init(&stream.ring, stream_data, sizeof(stream_data));
+    audio_buffer_init(&prompt.ring, prompt_data, sizeof(prompt_data));
+
+    audio_gain_init();
+    audio_eq_init();
+#ifdef CONFIG_ENABLE_AUDIO_LIMITER
+    audio_limiter_init();
+#endif
+
+    xTaskCreatePinnedToCore(audio_output_task, "audioOutputT", 3072, NULL, 10, &writer_task, 1);
+}
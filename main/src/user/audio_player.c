@@ -9,7 +9,6 @@
 #include "esp_system.h"
 
 #include "freertos/FreeRTOS.h"
-#include "driver/i2s.h"
 
 #include "mad.h"
 #include "frame.h"
@@ -17,7 +16,9 @@
 #include "stream.h"
 
 #include "core/os.h"
+#include "user/audio_output.h"
 #include "user/audio_player.h"
+#include "user/audio_render.h"
 
 #define TAG "audio_player"
 
@@ -74,6 +75,8 @@ static void audio_player_task(void *pvParameters)
         mad_frame_init(frame);
         mad_synth_init(synth);
 
+        audio_output_prompt_start();
+
         mad_stream_buffer(
             stream, (const unsigned char *)mp3_file_ptr[mp3_file_index][0],
             mp3_file_ptr[mp3_file_index][1] - mp3_file_ptr[mp3_file_index][0]
@@ -87,13 +90,15 @@ static void audio_player_task(void *pvParameters)
                 ESP_LOGE(TAG, "dec err 0x%04x (%s)", stream->error, mad_stream_errorstr(stream));
                 continue;
             }
-            mad_synth_frame(synth, frame);
+            render_frame(synth, frame);
         }
 
         mad_synth_finish(synth);
         mad_frame_finish(frame);
         mad_stream_finish(stream);
 
+        audio_output_prompt_stop();
+
         if (playback_pending) {
             playback_pending = 0;
         } else {
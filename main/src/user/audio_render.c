@@ -8,40 +8,89 @@
 #include "esp_log.h"
 
 #include "freertos/FreeRTOS.h"
-#include "driver/i2s.h"
 
-#include "chip/i2s.h"
+#include "mad.h"
+#include "frame.h"
+#include "synth.h"
 
-/* render callback for the libmad synth */
-void render_sample_block(short *sample_buff_ch0, short *sample_buff_ch1, int num_samples, unsigned int num_channels)
+#include "user/audio_output.h"
+#include "user/audio_render.h"
+
+#ifdef CONFIG_AUDIO_RENDER_BENCHMARK
+#include "xtensa/hal.h"
+
+#define TAG "audio_render"
+
+#define BENCH_FRAMES (64)
+
+static uint32_t bench_frames = 0;
+static uint32_t bench_synth  = 0;
+static uint32_t bench_sink[2] = {0};
+static uint8_t  bench_per_sample = 0;
+
+// the path this replaced: one driver call per stereo sample, each one queueing 4 bytes
+static void render_bench_per_sample(const short *samples, int num_samples)
+{
+    for (int i = 0; i < num_samples; i++) {
+        audio_output_write_prompt((const uint8_t *)&samples[i * 2], 2 * sizeof(short));
+    }
+}
+#endif
+
+/* synthesize one decoded frame into interleaved L/R samples and queue it to the prompt mixer */
+void render_frame(struct mad_synth *synth, struct mad_frame const *frame)
 {
-    // pointer to left / right sample position
-    char *ptr_l = (char*)sample_buff_ch0;
-    char *ptr_r = (char*)sample_buff_ch1;
-    uint8_t stride = sizeof(short);
+#ifdef CONFIG_AUDIO_RENDER_BENCHMARK
+    uint32_t start = xthal_get_ccount();
+#endif
 
-    if (num_channels == 1) {
-        ptr_r = ptr_l;
+    mad_synth_frame(synth, frame);
+
+    short *sample_buff = synth->pcm.samples;
+    int num_samples = synth->pcm.length;
+
+    if (synth->pcm.channels == 1) {
+        for (int i = 0; i < num_samples; i++) {
+            sample_buff[i * 2 + 1] = sample_buff[i * 2];
+        }
     }
 
-    size_t bytes_written = 0;
-    for (int i = 0; i < num_samples; i++) {
-        /* low - high / low - high */
-        const char samp32[4] = {ptr_l[0], ptr_l[1], ptr_r[0], ptr_r[1]}; // ESP32 CPU is Little Endian
-        i2s_write(CONFIG_AUDIO_OUTPUT_I2S_NUM, (const char *)&samp32, sizeof(samp32), &bytes_written, portMAX_DELAY);
-
-        // DMA buffer full - retry
-        if (bytes_written == 0) {
-            i--;
-        } else {
-            ptr_l += stride;
-            ptr_r += stride;
+#ifdef CONFIG_AUDIO_RENDER_BENCHMARK
+    uint32_t mid = xthal_get_ccount();
+
+    // waiting for the mixer to drain is pacing, only the queueing itself is timed
+    audio_output_wait_prompt(num_samples * 2 * sizeof(short));
+
+    uint32_t sink = xthal_get_ccount();
+
+    // alternate the two sinks every BENCH_FRAMES frames, the frame is queued exactly once either way
+    if (bench_per_sample) {
+        render_bench_per_sample(sample_buff, num_samples);
+    } else {
+        audio_output_write_prompt((const uint8_t *)sample_buff, num_samples * 2 * sizeof(short));
+    }
+
+    bench_synth += mid - start;
+    bench_sink[bench_per_sample] += xthal_get_ccount() - sink;
+    if (++bench_frames == BENCH_FRAMES) {
+        bench_frames = 0;
+        if (bench_per_sample) {
+            ESP_LOGI(TAG, "avg cycles/frame: synth %u, sink one call %u, sink per sample %u (%d samples)",
+                     bench_synth / (2 * BENCH_FRAMES), bench_sink[0] / BENCH_FRAMES,
+                     bench_sink[1] / BENCH_FRAMES, num_samples);
+            bench_synth   = 0;
+            bench_sink[0] = 0;
+            bench_sink[1] = 0;
         }
+        bench_per_sample ^= 1;
     }
+#else
+    audio_output_write_prompt((const uint8_t *)sample_buff, num_samples * 2 * sizeof(short));
+#endif
 }
 
-/* Called by the NXP modifications of libmad. Sets the needed output sample rate. */
+/* Called by the NXP modifications of libmad. The prompt is resampled to the output rate by the mixer. */
 void set_dac_sample_rate(int rate)
 {
-    i2s_output_set_sample_rate(rate);
+    audio_output_set_prompt_sample_rate(rate);
 }
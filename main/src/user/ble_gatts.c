@@ -17,9 +17,12 @@
 #include "core/os.h"
 #include "core/app.h"
 #include "user/vfx.h"
+#include "user/vfx_spectrum.h"
 #include "user/ble_app.h"
 #include "user/ble_gatts.h"
+#include "user/audio_eq.h"
 #include "user/audio_input.h"
+#include "user/audio_limiter.h"
 
 #define BLE_GATTS_TAG "ble_gatts"
 
@@ -151,15 +154,20 @@ static void profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t ga
 
         memset(&rsp, 0, sizeof(esp_gatt_rsp_t));
         rsp.attr_value.handle = param->read.handle;
-        rsp.attr_value.len = 8;
+        rsp.attr_value.len = 9;
         /*
             BTT0: VFX Enabled
             BIT1: Backlight Enabled
             BIT2: Cube Mode Enabled
             BIT3: Audio Input Enabled
+            BIT4: Audio EQ Enabled
+            BIT5: Audio Limiter Enabled
         */
         rsp.attr_value.value[0] = (
-            0
+            BIT4
+#ifdef CONFIG_ENABLE_AUDIO_LIMITER
+            | BIT5
+#endif
 #ifdef CONFIG_ENABLE_VFX
             | BIT0
     #ifndef CONFIG_VFX_OUTPUT_CUBE0414
@@ -184,6 +192,11 @@ static void profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t ga
         rsp.attr_value.value[7] = ain_mode;
     #endif
 #endif
+#ifdef CONFIG_ENABLE_AUDIO_LIMITER
+        // peak gain reduction since the last read, in 0.1 dB
+        uint16_t reduction = audio_limiter_get_reduction();
+        rsp.attr_value.value[8] = reduction > 0xFF ? 0xFF : reduction;
+#endif
 
         esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, ESP_GATT_OK, &rsp);
         break;
@@ -231,6 +244,54 @@ static void profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t ga
                     }
                     break;
                 }
+                case 0xEE: {
+                    audio_eq_config_t eq;
+                    memcpy(&eq, audio_eq_get_conf(), sizeof(audio_eq_config_t));
+                    if (param->write.len == 1) {    // Restore Default EQ Configuration
+                        memset(&eq, 0x00, sizeof(audio_eq_config_t));
+                        audio_eq_set_conf(&eq);
+                        app_setenv("EQ_INIT_CFG", &eq, sizeof(audio_eq_config_t));
+                    } else if (param->write.len == 9 && param->write.value[1] < AUDIO_EQ_BANDS_MAX
+                               && param->write.value[2] < AUDIO_EQ_TYPE_MAX) { // Update EQ Band
+                        audio_eq_band_t *band = &eq.band[param->write.value[1]];
+                        band->type = param->write.value[2];
+                        band->freq = param->write.value[3] << 8 | param->write.value[4];
+                        band->gain = param->write.value[5] << 8 | param->write.value[6];
+                        band->q = param->write.value[7] << 8 | param->write.value[8];
+                        audio_eq_set_conf(&eq);
+                        app_setenv("EQ_INIT_CFG", &eq, sizeof(audio_eq_config_t));
+                    } else {
+                        ESP_LOGE(BLE_GATTS_TAG, "command 0x%02X error", param->write.value[0]);
+                    }
+                    break;
+                }
+                case 0xED: {
+#ifdef CONFIG_ENABLE_VFX
+                    vfx_spectrum_config_t *fft = vfx_spectrum_get_conf();
+                    if (param->write.len == 1) {    // Restore Default FFT Configuration
+                        fft->size = DEFAULT_VFX_SPECTRUM_SIZE;
+                        fft->window = DEFAULT_VFX_SPECTRUM_WINDOW;
+                        fft->scale = DEFAULT_VFX_SPECTRUM_SCALE;
+                        vfx_spectrum_set_conf(fft);
+                        app_setenv("FFT_INIT_CFG", fft, sizeof(vfx_spectrum_config_t));
+                    } else if (param->write.len == 5 && param->write.value[3] < VFX_SPECTRUM_WINDOW_MAX
+                               && param->write.value[4] < VFX_SPECTRUM_SCALE_MAX) { // Update FFT Configuration
+                        uint16_t size = param->write.value[1] << 8 | param->write.value[2];
+                        if (size != 256 && size != 512 && size != 1024) {
+                            ESP_LOGE(BLE_GATTS_TAG, "command 0x%02X error", param->write.value[0]);
+                            break;
+                        }
+                        fft->size = size;
+                        fft->window = param->write.value[3];
+                        fft->scale = param->write.value[4];
+                        vfx_spectrum_set_conf(fft);
+                        app_setenv("FFT_INIT_CFG", fft, sizeof(vfx_spectrum_config_t));
+                    } else {
+                        ESP_LOGE(BLE_GATTS_TAG, "command 0x%02X error", param->write.value[0]);
+                    }
+#endif
+                    break;
+                }
                 default:
                     ESP_LOGW(BLE_GATTS_TAG, "unknown command: 0x%02X", param->write.value[0]);
                     break;
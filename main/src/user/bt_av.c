@@ -19,18 +19,18 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/i2s.h"
 
 #include "core/os.h"
 #include "core/app.h"
-#include "chip/i2s.h"
 #include "user/led.h"
-#include "user/vfx.h"
+#include "user/vfx_spectrum.h"
 #include "user/bt_av.h"
 #include "user/bt_app.h"
 #include "user/ble_app.h"
 #include "user/bt_app_core.h"
+#include "user/audio_gain.h"
 #include "user/audio_input.h"
+#include "user/audio_output.h"
 #include "user/audio_player.h"
 
 #define BT_A2D_TAG   "bt_a2d"
@@ -57,6 +57,8 @@ static const char *s_a2d_audio_state_str[] = {"suspended", "stopped", "started"}
 
 static esp_avrc_rn_evt_cap_mask_t s_avrc_peer_rn_cap;
 
+static bool s_volume_notify = false;
+
 static int sample_rate = 16000;
 
 esp_bd_addr_t a2d_remote_bda = {0};
@@ -78,20 +80,11 @@ void bt_app_a2d_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
 
 void bt_app_a2d_data_cb(const uint8_t *data, uint32_t len)
 {
-#if !defined(CONFIG_AUDIO_INPUT_NONE) || defined(CONFIG_ENABLE_AUDIO_PROMPT) || defined(CONFIG_ENABLE_VFX)
+#if !defined(CONFIG_AUDIO_INPUT_NONE) || defined(CONFIG_ENABLE_VFX)
     EventBits_t uxBits = xEventGroupGetBits(user_event_group);
 #endif
 
-#ifdef CONFIG_ENABLE_AUDIO_PROMPT
-    if (uxBits & AUDIO_PLAYER_RUN_BIT) {
-        return;
-    }
-#endif
-
-    i2s_output_set_sample_rate(sample_rate);
-
-    size_t bytes_written = 0;
-    i2s_write(CONFIG_AUDIO_OUTPUT_I2S_NUM, data, len, &bytes_written, portMAX_DELAY);
+    audio_output_write(data, len);
 
 #ifndef CONFIG_AUDIO_INPUT_NONE
     if (uxBits & AUDIO_INPUT_RUN_BIT) {
@@ -100,38 +93,17 @@ void bt_app_a2d_data_cb(const uint8_t *data, uint32_t len)
 #endif
 
 #ifdef CONFIG_ENABLE_VFX
-    if (!(uxBits & VFX_FFT_NULL_BIT)) {
+    if (!(uxBits & AUDIO_INPUT_FFT_BIT)) {
         return;
     }
 
-    // Copy data to FFT input buffer
-    uint32_t idx = 0;
-
 #ifdef CONFIG_BT_AUDIO_FFT_ONLY_LEFT
-    int16_t data_l = 0;
-    for (uint16_t k=0; k<FFT_N; k++,idx+=4) {
-        data_l = data[idx+1] << 8 | data[idx];
-
-        vfx_fft_input[k] = (float)data_l;
-    }
+    vfx_spectrum_write(data, len, VFX_SPECTRUM_CHANNEL_LEFT);
 #elif defined(CONFIG_BT_AUDIO_FFT_ONLY_RIGHT)
-    int16_t data_r = 0;
-    for (uint16_t k=0; k<FFT_N; k++,idx+=4) {
-        data_r = data[idx+3] << 8 | data[idx+2];
-
-        vfx_fft_input[k] = (float)data_r;
-    }
+    vfx_spectrum_write(data, len, VFX_SPECTRUM_CHANNEL_RIGHT);
 #else
-    int16_t data_l = 0, data_r = 0;
-    for (uint16_t k=0; k<FFT_N; k++,idx+=4) {
-        data_l = data[idx+1] << 8 | data[idx];
-        data_r = data[idx+3] << 8 | data[idx+2];
-
-        vfx_fft_input[k] = (float)((data_l + data_r) / 2);
-    }
+    vfx_spectrum_write(data, len, VFX_SPECTRUM_CHANNEL_BOTH);
 #endif
-
-    xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
 #endif
 }
 
@@ -203,8 +175,7 @@ static void bt_av_hdl_a2d_evt(uint16_t event, void *p_param)
                 if (!(uxBits & BT_A2DP_IDLE_BIT)) {
 #ifdef CONFIG_ENABLE_VFX
                     if (!(uxBits & AUDIO_INPUT_RUN_BIT) && (uxBits & AUDIO_INPUT_FFT_BIT)) {
-                        memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-                        xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
+                        vfx_spectrum_clear();
                     }
 #endif
                 }
@@ -238,13 +209,17 @@ static void bt_av_hdl_a2d_evt(uint16_t event, void *p_param)
     }
     case ESP_A2D_AUDIO_STATE_EVT: {
         ESP_LOGI(BT_A2D_TAG, "A2DP audio state: %s", s_a2d_audio_state_str[a2d->audio_stat.state]);
-#ifdef CONFIG_ENABLE_LED
         if (a2d->audio_stat.state == ESP_A2D_AUDIO_STATE_STARTED) {
+            audio_output_start();
+#ifdef CONFIG_ENABLE_LED
             led_set_mode(1);
+#endif
         } else {
+            audio_output_stop();
+#ifdef CONFIG_ENABLE_LED
             led_set_mode(2);
-        }
 #endif
+        }
         break;
     }
     case ESP_A2D_AUDIO_CFG_EVT: {
@@ -269,6 +244,11 @@ static void bt_av_hdl_a2d_evt(uint16_t event, void *p_param)
                      a2d->audio_cfg.mcc.cie.sbc[2],
                      a2d->audio_cfg.mcc.cie.sbc[3]);
             ESP_LOGI(BT_A2D_TAG, "audio player configured, sample rate=%d", sample_rate);
+
+            audio_output_set_sample_rate(sample_rate);
+#ifdef CONFIG_ENABLE_VFX
+            vfx_spectrum_set_sample_rate(sample_rate);
+#endif
         }
 
         break;
@@ -388,6 +368,9 @@ static void bt_av_hdl_avrc_tg_evt(uint16_t event, void *p_param)
                  rc->conn_stat.remote_bda[0], rc->conn_stat.remote_bda[1],
                  rc->conn_stat.remote_bda[2], rc->conn_stat.remote_bda[3],
                  rc->conn_stat.remote_bda[4], rc->conn_stat.remote_bda[5]);
+        if (!rc->conn_stat.connected) {
+            s_volume_notify = false;
+        }
         break;
     }
     case ESP_AVRC_TG_PASSTHROUGH_CMD_EVT: {
@@ -396,10 +379,27 @@ static void bt_av_hdl_avrc_tg_evt(uint16_t event, void *p_param)
     }
     case ESP_AVRC_TG_SET_ABSOLUTE_VOLUME_CMD_EVT: {
         ESP_LOGI(BT_RC_TG_TAG, "AVRC set absolute volume: %d%%", (int)rc->set_abs_vol.volume * 100 / 0x7f);
+        audio_gain_set_volume(rc->set_abs_vol.volume);
+
+        // complete a pending volume change notification, the source registers again after this
+        if (s_volume_notify) {
+            s_volume_notify = false;
+
+            esp_avrc_rn_param_t rn_param;
+            rn_param.volume = audio_gain_get_volume();
+            esp_avrc_tg_send_rn_rsp(ESP_AVRC_RN_VOLUME_CHANGE, ESP_AVRC_RN_RSP_CHANGED, &rn_param);
+        }
         break;
     }
     case ESP_AVRC_TG_REGISTER_NOTIFICATION_EVT: {
         ESP_LOGI(BT_RC_TG_TAG, "AVRC register event notification: %d, param: 0x%x", rc->reg_ntf.event_id, rc->reg_ntf.event_parameter);
+        if (rc->reg_ntf.event_id == ESP_AVRC_RN_VOLUME_CHANGE) {
+            s_volume_notify = true;
+
+            esp_avrc_rn_param_t rn_param;
+            rn_param.volume = audio_gain_get_volume();
+            esp_avrc_tg_send_rn_rsp(ESP_AVRC_RN_VOLUME_CHANGE, ESP_AVRC_RN_RSP_INTERIM, &rn_param);
+        }
         break;
     }
     case ESP_AVRC_TG_REMOTE_FEATURES_EVT: {
@@ -9,19 +9,35 @@
 #include <string.h>
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
-#include "fft.h"
 #include "gfx.h"
 
 #include "core/os.h"
 #include "core/app.h"
 #include "user/vfx.h"
 #include "user/vfx_core.h"
+#include "user/vfx_bar.h"
+#include "user/vfx_beat.h"
 #include "user/vfx_bitmap.h"
+#include "user/vfx_spectrum.h"
 #include "user/audio_input.h"
 
+#ifdef CONFIG_VFX_BARS_BENCHMARK
+#include "xtensa/hal.h"
+#endif
+
 #define TAG "vfx"
 
+// consecutive missed deadlines before the frame period is stretched
+#define VFX_FRAME_MISS_MAX   (8)
+// frames finished within half the period before it shrinks back
+#define VFX_FRAME_SLACK_MIN  (64)
+
+#ifdef CONFIG_VFX_BARS_BENCHMARK
+#define BENCH_FRAMES (256)
+#endif
+
 static vfx_config_t vfx = {
     .mode = DEFAULT_VFX_MODE,
     .scale_factor = DEFAULT_VFX_SCALE_FACTOR,
@@ -31,12 +47,12 @@ static vfx_config_t vfx = {
 
 GDisplay *vfx_gdisp = NULL;
 
-float vfx_fft_input[FFT_N] = {0.0};
-float vfx_fft_output[FFT_N] = {0.0};
-
 static coord_t vfx_disp_width = 0;
 static coord_t vfx_disp_height = 0;
 
+static uint16_t vfx_frame_period = 0;   // current frame period in ms
+static uint16_t vfx_frame_nominal = 0;  // frame period requested by the effect
+
 #ifdef CONFIG_SCREEN_PANEL_OUTPUT_VFX
 static const char *img_file_ptr[][2] = {
     #ifdef CONFIG_VFX_OUTPUT_ST7735
@@ -47,1900 +63,1343 @@ static const char *img_file_ptr[][2] = {
         {ani1_240x135_gif_ptr, ani1_240x135_gif_end},   // "bilibili"
     #endif
 };
-#endif
-
-static void vfx_task(void *pvParameter)
-{
-    portTickType xLastWakeTime;
-
-    gfxInit();
-
-    vfx_gdisp = gdispGetDisplay(0);
-    vfx_disp_width = gdispGGetWidth(vfx_gdisp);
-    vfx_disp_height = gdispGGetHeight(vfx_gdisp);
-
-    ESP_LOGI(TAG, "started.");
-
-    while (1) {
-        switch (vfx.mode) {
-#ifdef CONFIG_SCREEN_PANEL_OUTPUT_VFX
-        // LCD Output
-        case 0x00:
-        case 0x01: {   // 動態貼圖
-            gdispImage gfx_image;
-
-            if (!(gdispImageOpenMemory(&gfx_image, img_file_ptr[vfx.mode][0]) & GDISP_IMAGE_ERR_UNRECOVERABLE)) {
-                gdispImageSetBgColor(&gfx_image, Black);
-
-                gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-                while (1) {
-                    xLastWakeTime = xTaskGetTickCount();
-
-                    if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                        xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                        break;
-                    }
-
-                    if (gdispImageDraw(&gfx_image, 0, 0, gfx_image.width, gfx_image.height, 0, 0) != GDISP_IMAGE_ERR_OK) {
-                        ESP_LOGE(TAG, "failed to draw image: %u", vfx.mode);
-                        vfx.mode = VFX_MODE_IDX_OFF;
-                        break;
-                    }
-
-                    delaytime_t delay = gdispImageNext(&gfx_image);
-                    if (delay == TIME_INFINITE) {
-                        vfx.mode = VFX_MODE_IDX_PAUSE;
-                        break;
-                    }
-
-                    if (delay != TIME_IMMEDIATE) {
-                        vTaskDelayUntil(&xLastWakeTime, delay / portTICK_RATE_MS);
-                    }
-                }
-
-                gdispImageClose(&gfx_image);
-            } else {
-                ESP_LOGE(TAG, "failed to open image: %u", vfx.mode);
-                vfx.mode = VFX_MODE_IDX_OFF;
-                break;
-            }
-            break;
-        }
-        case 0x0D: {   // 音樂頻譜-漸變-線性
-            uint16_t color_tmp = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
-
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
-
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
-
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
-
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
-
-                    fft_execute(fft);
-
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
-
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = fft_amp[0] / (65536 / vfx_disp_height) * vfx.scale_factor;
-                    if (fft_out[0] > vfx_disp_height) {
-                        fft_out[0] = vfx_disp_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
-
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = fft_amp[k] / (65536 / vfx_disp_height) * vfx.scale_factor;
-                        if (fft_out[k] > vfx_disp_height) {
-                            fft_out[k] = vfx_disp_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
-                    }
-                }
-
-                color_tmp = color_h;
-                for (uint16_t i=0; i<vfx_disp_width; i++) {
-                    uint32_t pixel_color = vfx_read_color_from_table(color_h, color_l);
 
 #if defined(CONFIG_VFX_OUTPUT_ST7735)
-                    uint16_t clear_x  = i * 3;
-                    uint16_t clear_cx = 3;
-                    uint16_t clear_y  = 0;
-                    uint16_t clear_cy = vfx_disp_height - fft_out[i];
-
-                    uint16_t fill_x  = i * 3;
-                    uint16_t fill_cx = 3;
-                    uint16_t fill_y  = vfx_disp_height - fft_out[i];
-                    uint16_t fill_cy = fft_out[i];
+    #define VFX_BAR_WIDTH 3
+
+    static const uint8_t vu_idx_min = 0;
+    static const uint8_t vu_idx_max = 19;
+    static const uint8_t vu_val_min = 0;
+    static const uint8_t vu_val_max = 19;
+    static const uint8_t vu_height = 4;
+    static const uint8_t vu_width = 8;
+    static const uint8_t vu_step = 9;
 #else
-                    uint16_t clear_x  = i * 4;
-                    uint16_t clear_cx = 4;
-                    uint16_t clear_y  = 0;
-                    uint16_t clear_cy = vfx_disp_height - fft_out[i];
-
-                    uint16_t fill_x  = i * 4;
-                    uint16_t fill_cx = 4;
-                    uint16_t fill_y  = vfx_disp_height - fft_out[i];
-                    uint16_t fill_cy = fft_out[i];
+    #define VFX_BAR_WIDTH 4
+
+    static const uint8_t vu_idx_min = 0;
+    static const uint8_t vu_idx_max = 23;
+    static const uint8_t vu_val_min = 0;
+    static const uint8_t vu_val_max = 26;
+    static const uint8_t vu_height = 5;
+    static const uint8_t vu_width = 10;
+    static const uint8_t vu_step = 6;
 #endif
 
-                    gdispGFillArea(vfx_gdisp, clear_x, clear_y, clear_cx, clear_cy, 0x000000);
-                    gdispGFillArea(vfx_gdisp, fill_x, fill_y, fill_cx, fill_cy, pixel_color);
-
-                    if (color_h++ == 511) {
-                        color_h = 0;
-                    }
-                }
-
-                if (color_tmp++ == 511) {
-                    color_h = 0;
-                } else {
-                    color_h = color_tmp;
-                }
-
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
-
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            fft_destroy(fft);
-
-            break;
-        }
-        case 0x0E: {   // 音樂頻譜-彩虹-線性
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
-
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
-
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
-
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
-
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
-
-                    fft_execute(fft);
-
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
-
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = fft_amp[0] / (65536 / vfx_disp_height) * vfx.scale_factor;
-                    if (fft_out[0] > vfx_disp_height) {
-                        fft_out[0] = vfx_disp_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
-
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = fft_amp[k] / (65536 / vfx_disp_height) * vfx.scale_factor;
-                        if (fft_out[k] > vfx_disp_height) {
-                            fft_out[k] = vfx_disp_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
-                    }
-                }
-
-                color_h = 511;
-                for (uint16_t i=0; i<vfx_disp_width; i++) {
-                    uint32_t pixel_color = vfx_read_color_from_table(color_h, color_l);
+static const vfx_bar_config_t vu_bar_conf = {
+    .attack = 1.0,
+    .release = 0.3,
+    .gravity = 0.003,
+    .hold = 10,
+};
 
-#if defined(CONFIG_VFX_OUTPUT_ST7735)
-                    uint16_t clear_x  = i * 3;
-                    uint16_t clear_cx = 3;
-                    uint16_t clear_y  = 0;
-                    uint16_t clear_cy = vfx_disp_height - fft_out[i];
-
-                    uint16_t fill_x  = i * 3;
-                    uint16_t fill_cx = 3;
-                    uint16_t fill_y  = vfx_disp_height - fft_out[i];
-                    uint16_t fill_cy = fft_out[i];
-#else
-                    uint16_t clear_x  = i * 4;
-                    uint16_t clear_cx = 4;
-                    uint16_t clear_y  = 0;
-                    uint16_t clear_cy = vfx_disp_height - fft_out[i];
-
-                    uint16_t fill_x  = i * 4;
-                    uint16_t fill_cx = 4;
-                    uint16_t fill_y  = vfx_disp_height - fft_out[i];
-                    uint16_t fill_cy = fft_out[i];
+// state of the running effect, effects never run at the same time
+static union {
+    struct {
+        gdispImage image;
+    } gif;
+    struct {
+        bool log_scale;
+        uint16_t bar_num;
+        uint16_t center_y;
+        uint16_t half_max;
+        uint16_t color_h;
+        int16_t fft_out[2][VFX_SPECTRUM_BANDS_MAX];
+        int16_t peak[VFX_SPECTRUM_BANDS_MAX];
+        // what is on the screen now, only the difference gets drawn
+        int16_t prev_top[VFX_SPECTRUM_BANDS_MAX];
+        int16_t prev_bot[VFX_SPECTRUM_BANDS_MAX];
+        uint32_t prev_color[VFX_SPECTRUM_BANDS_MAX];
+        // back buffer of this frame and the rows drawn into it
+        uint16_t *fb;
+        int16_t dirty_y0;
+        int16_t dirty_y1;
+        uint32_t pixels;
+        uint32_t pixels_max;
+        uint64_t pixels_sum;
+        uint32_t frames;
+#ifdef CONFIG_VFX_BARS_BENCHMARK
+        uint32_t bench_start;
+        uint32_t bench_cycles;
+        uint32_t bench_pixels;
 #endif
-
-                    gdispGFillArea(vfx_gdisp, clear_x, clear_y, clear_cx, clear_cy, 0x000000);
-                    gdispGFillArea(vfx_gdisp, fill_x, fill_y, fill_cx, fill_cy, pixel_color);
-
-                    if ((color_h -= 8) == 7) {
-                        color_h = 511;
-                    }
-                }
-
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
-
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            fft_destroy(fft);
-
-            break;
-        }
-        case 0x0F: {   // 音樂頻譜-电平-線性
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-#if defined(CONFIG_VFX_OUTPUT_ST7735)
-            const uint8_t vu_idx_min = 0;
-            const uint8_t vu_idx_max = 19;
-            const uint8_t vu_val_min = 0;
-            const uint8_t vu_val_max = 19;
-            const uint8_t vu_height = 4;
-            const uint8_t vu_width = 8;
-            const uint8_t vu_step = 9;
+    } bars;
+} fx;
 #else
-            const uint8_t vu_idx_min = 0;
-            const uint8_t vu_idx_max = 23;
-            const uint8_t vu_val_min = 0;
-            const uint8_t vu_val_max = 26;
-            const uint8_t vu_height = 5;
-            const uint8_t vu_width = 10;
-            const uint8_t vu_step = 6;
-#endif
-            static int8_t vu_val_peak[24] = {0};
-            static int8_t vu_peak_delay[24] = {0};
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
-
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
+static const uint8_t vfx_fountain_h_table[][64] = {
+    {
+        3, 4, 4, 3, 2, 2, 2, 3, 4, 5, 5, 5, 5, 4, 3, 2,
+        1, 1, 1, 1, 1, 2, 3, 4, 5, 6, 6, 6, 6, 6, 6, 5,
+        4, 3, 2, 1, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5,
+        6, 7, 7, 7, 7, 7, 7, 7, 7, 6, 5, 4, 3, 2, 1, 0,
+    },
+    {
+        3, 3, 4, 4, 4, 3, 2, 2, 2, 2, 3, 4, 5, 5, 5, 5,
+        5, 4, 3, 2, 1, 1, 1, 1, 1, 1, 2, 3, 4, 5, 6, 6,
+        6, 6, 6, 6, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0, 0,
+        0, 0, 1, 2, 3, 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7,
+    }
+};
 
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+static const coord_t canvas_width = 64;
+static const coord_t canvas_height = 8;
+
+// state of the running effect, effects never run at the same time
+static union {
+    struct {
+        uint16_t color_h;
+        uint32_t beat_count;
+    } rainbow;
+    struct {
+        uint16_t color_h;
+    } ribbon;
+    struct {
+        uint16_t color_h;
+        uint16_t color_l;
+        uint8_t scale_dir;
+    } gradual;
+    struct {
+        uint16_t led_num;
+        uint16_t led_idx[512];
+        uint16_t color_h[512];
+        int16_t idx_base;
+        uint16_t step;
+    } star_sky;
+    struct {
+        uint16_t num;
+        uint16_t step;
+        uint16_t color_h;
+    } numbers;
+    struct {
+        uint16_t frame_idx;
+        uint16_t color_h;
+        uint32_t color[VFX_CUBE_N * VFX_CUBE_N + VFX_CUBE_N];
+    } bitmap;
+    struct {
+        bool log_scale;
+        uint8_t color_flg;
+        uint8_t color_cnt;
+        uint16_t color_tmp;
+        uint16_t color_h[64];
+        uint16_t color_l[64];
+        int16_t fft_out[2][VFX_SPECTRUM_BANDS_MAX];
+    } fountain;
+} fx;
+#endif
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+static void vfx_set_frame_period(uint16_t period)
+{
+    vfx_frame_period = period;
+    vfx_frame_nominal = period;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+#ifdef CONFIG_SCREEN_PANEL_OUTPUT_VFX
+// LCD Output
+/* a requested period from a running effect, a changed one starts over unstretched */
+static void vfx_set_frame_nominal(uint16_t period)
+{
+    // only missed deadlines at the new period may stretch it again
+    if (period != vfx_frame_nominal) {
+        vfx_set_frame_period(period);
+    }
+}
 
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
+static bool vfx_gif_init(void)   // 動態貼圖
+{
+    if (gdispImageOpenMemory(&fx.gif.image, img_file_ptr[vfx.mode][0]) & GDISP_IMAGE_ERR_UNRECOVERABLE) {
+        ESP_LOGE(TAG, "failed to open image: %u", vfx.mode);
+        vfx.mode = VFX_MODE_IDX_OFF;
+        return false;
+    }
 
-                    fft_execute(fft);
+    gdispImageSetBgColor(&fx.gif.image, Black);
 
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+    return true;
+}
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = fft_amp[0] / (65536 / vfx_disp_height) * vfx.scale_factor;
-                    if (fft_out[0] > vfx_disp_height) {
-                        fft_out[0] = vfx_disp_height;
-                    } else if (fft_out[0] < 0) {
-                        fft_out[0] = 0;
-                    }
+static bool vfx_gif_render(uint32_t frame, uint32_t dt)
+{
+    if (gdispImageDraw(&fx.gif.image, 0, 0, fx.gif.image.width, fx.gif.image.height, 0, 0) != GDISP_IMAGE_ERR_OK) {
+        ESP_LOGE(TAG, "failed to draw image: %u", vfx.mode);
+        vfx.mode = VFX_MODE_IDX_OFF;
+        return false;
+    }
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = fft_amp[k] / (65536 / vfx_disp_height) * vfx.scale_factor;
-                        if (fft_out[k] > vfx_disp_height) {
-                            fft_out[k] = vfx_disp_height;
-                        } else if (fft_out[k] < 0) {
-                            fft_out[k] = 0;
-                        }
-                    }
-                }
+    delaytime_t delay = gdispImageNext(&fx.gif.image);
+    if (delay == TIME_INFINITE) {
+        vfx.mode = VFX_MODE_IDX_PAUSE;
+        return false;
+    }
 
-                for (uint8_t i=vu_idx_min; i<=vu_idx_max; i++) {
-                    int16_t vu_val_out = fft_out[i];
+    vfx_set_frame_nominal(delay == TIME_IMMEDIATE ? 0 : delay);
 
-                    if (vu_val_out > vu_val_max) {
-                        vu_val_out = vu_val_max;
-                    } else if (vu_val_out < vu_val_min) {
-                        vu_val_out = vu_val_min;
-                    }
+    return true;
+}
 
-                    if (vu_peak_delay[i]-- == 0) {
-                        vu_peak_delay[i] = 2;
-                        vu_val_peak[i]--;
-                    }
-                    if (vu_val_peak[i] <= vu_val_out) {
-                        vu_val_peak[i] = vu_val_out;
-                    }
-                    if (vu_val_peak[i] != vu_val_out) {
-                        gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-vu_val_peak[i])*vu_height+1, vu_width-2, vu_height-2, 0x000000);
-                    }
-                    gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-vu_val_peak[i])*vu_height+1, vu_width-2, vu_height-2, 0xFF00FF);
+static void vfx_gif_teardown(void)
+{
+    gdispImageClose(&fx.gif.image);
+}
 
-                    color_h = 511;
-                    for (int8_t j=vu_val_max; j>=vu_val_min; j--) {
-                        uint32_t pixel_color = vfx_read_color_from_table(color_h, color_l);
+// fills straight into the back buffer, the rows are handed to the driver once per frame
+static void vfx_bars_fill(uint16_t x, int16_t y, uint16_t cx, int16_t cy, uint32_t color)
+{
+    if (y < 0) {
+        cy += y;
+        y = 0;
+    }
+    if (y + cy > vfx_disp_height) {
+        cy = vfx_disp_height - y;
+    }
+    if (cy <= 0 || x >= vfx_disp_width) {
+        return;
+    }
+    if (x + cx > vfx_disp_width) {
+        cx = vfx_disp_width - x;
+    }
 
-                        if (j == vu_val_peak[i]) {
-                            continue;
-                        }
+    // the back buffer changes with every flush
+    if (fx.bars.fb == NULL) {
+        fx.bars.fb = vfx_get_framebuffer();
+        fx.bars.dirty_y0 = vfx_disp_height;
+        fx.bars.dirty_y1 = 0;
+    }
 
-                        if (j > vu_val_out || ((j == 0) && (vu_val_out == 0))) { // Upside
-                            gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-j)*vu_height+1, vu_width-2, vu_height-2, 0x000000);
-                        } else { // Underside
-                            gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-j)*vu_height+1, vu_width-2, vu_height-2, pixel_color);
-                        }
+    if (fx.bars.fb == NULL) {
+        gdispGFillArea(vfx_gdisp, x, y, cx, cy, color);
+    } else {
+        uint16_t c = vfx_native_color(color);
+        uint16_t *row = fx.bars.fb + x + y * vfx_disp_width;
 
-                        color_h -= vu_step;
-                    }
-                }
-
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
+        for (int16_t j=0; j<cy; j++, row+=vfx_disp_width) {
+            for (uint16_t i=0; i<cx; i++) {
+                row[i] = c;
             }
-
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            fft_destroy(fft);
-
-            break;
         }
-        case 0x10: {   // 音樂頻譜-漸變-對數
-            uint16_t color_tmp = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            uint16_t center_y = vfx_disp_height % 2 ? vfx_disp_height / 2 : vfx_disp_height / 2 - 1;
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
-
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
-
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
-
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
-
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
-
-                    fft_execute(fft);
-
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
-
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = 20 * log10(fft_amp[0]) / (65536 / vfx_disp_height) * vfx.scale_factor;
-                    if (fft_out[0] > center_y) {
-                        fft_out[0] = center_y;
-                    } else if (fft_out[0] < 0) {
-                        fft_out[0] = 0;
-                    }
-
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = 20 * log10(fft_amp[k]) / (65536 / vfx_disp_height) * vfx.scale_factor;
-                        if (fft_out[k] > center_y) {
-                            fft_out[k] = center_y;
-                        } else if (fft_out[k] < 0) {
-                            fft_out[k] = 0;
-                        }
-                    }
-                }
-
-                color_tmp = color_h;
-                for (uint16_t i=0; i<vfx_disp_width; i++) {
-                    uint32_t pixel_color = vfx_read_color_from_table(color_h, color_l);
-
-#if defined(CONFIG_VFX_OUTPUT_ST7735)
-                    uint16_t clear_x  = i * 3;
-                    uint16_t clear_cx = 3;
-                    uint16_t clear_u_y = 0;
-                    uint16_t clear_d_y = center_y + fft_out[i] + 2;
-                    uint16_t clear_cy  = center_y - fft_out[i];
-
-                    uint16_t fill_x  = i * 3;
-                    uint16_t fill_cx = 3;
-                    uint16_t fill_y  = center_y - fft_out[i];
-                    uint16_t fill_cy = fft_out[i] * 2 + 2;
-#else
-                    uint16_t clear_x  = i * 4;
-                    uint16_t clear_cx = 4;
-                    uint16_t clear_u_y = 0;
-                    uint16_t clear_d_y = center_y + fft_out[i] + 1;
-                    uint16_t clear_cy  = center_y - fft_out[i];
-
-                    uint16_t fill_x  = i * 4;
-                    uint16_t fill_cx = 4;
-                    uint16_t fill_y  = center_y - fft_out[i];
-                    uint16_t fill_cy = fft_out[i] * 2 + 1;
-#endif
 
-                    gdispGFillArea(vfx_gdisp, clear_x, clear_u_y, clear_cx, clear_cy, 0x000000);
-                    gdispGFillArea(vfx_gdisp, clear_x, clear_d_y, clear_cx, clear_cy, 0x000000);
-                    gdispGFillArea(vfx_gdisp, fill_x, fill_y, fill_cx, fill_cy, pixel_color);
+        if (y < fx.bars.dirty_y0) {
+            fx.bars.dirty_y0 = y;
+        }
+        if (y + cy > fx.bars.dirty_y1) {
+            fx.bars.dirty_y1 = y + cy;
+        }
+    }
 
-                    if (color_h++ == 511) {
-                        color_h = 0;
-                    }
-                }
+    fx.bars.pixels += cx * cy;
+}
 
-                if (color_tmp++ == 511) {
-                    color_h = 0;
-                } else {
-                    color_h = color_tmp;
-                }
+// redraw bar i as the span [top, bot) in color, touching only what differs from the last frame
+static void vfx_bars_draw_span(uint16_t i, int16_t top, int16_t bot, uint32_t color)
+{
+    uint16_t x = i * VFX_BAR_WIDTH;
+    int16_t prev_top = fx.bars.prev_top[i];
+    int16_t prev_bot = fx.bars.prev_bot[i];
+
+    if (prev_top >= prev_bot) {
+        vfx_bars_fill(x, top, VFX_BAR_WIDTH, bot - top, color);
+    } else {
+        // shrinking
+        if (prev_top < top) {
+            vfx_bars_fill(x, prev_top, VFX_BAR_WIDTH, (top < prev_bot ? top : prev_bot) - prev_top, 0x000000);
+        }
+        if (prev_bot > bot) {
+            int16_t clear_y = bot > prev_top ? bot : prev_top;
+            vfx_bars_fill(x, clear_y, VFX_BAR_WIDTH, prev_bot - clear_y, 0x000000);
+        }
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
+        if (color != fx.bars.prev_color[i]) {
+            // recolour
+            vfx_bars_fill(x, top, VFX_BAR_WIDTH, bot - top, color);
+        } else {
+            // growing
+            if (top < prev_top) {
+                vfx_bars_fill(x, top, VFX_BAR_WIDTH, (bot < prev_top ? bot : prev_top) - top, color);
+            }
+            if (bot > prev_bot) {
+                int16_t fill_y = top > prev_bot ? top : prev_bot;
+                vfx_bars_fill(x, fill_y, VFX_BAR_WIDTH, bot - fill_y, color);
             }
-
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            fft_destroy(fft);
-
-            break;
         }
-        case 0x11: {   // 音樂頻譜-彩虹-對數
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            uint16_t center_y = vfx_disp_height % 2 ? vfx_disp_height / 2 : vfx_disp_height / 2 - 1;
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
-
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
-
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
-
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
-
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
-
-                    fft_execute(fft);
-
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
-
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = 20 * log10(fft_amp[0]) / (65536 / vfx_disp_height) * vfx.scale_factor;
-                    if (fft_out[0] > center_y) {
-                        fft_out[0] = center_y;
-                    } else if (fft_out[0] < 0) {
-                        fft_out[0] = 0;
-                    }
-
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = 20 * log10(fft_amp[k]) / (65536 / vfx_disp_height) * vfx.scale_factor;
-                        if (fft_out[k] > center_y) {
-                            fft_out[k] = center_y;
-                        } else if (fft_out[k] < 0) {
-                            fft_out[k] = 0;
-                        }
-                    }
-                }
+    }
 
-                color_h = 511;
-                for (uint16_t i=0; i<vfx_disp_width; i++) {
-                    uint32_t pixel_color = vfx_read_color_from_table(color_h, color_l);
+    fx.bars.prev_top[i] = top;
+    fx.bars.prev_bot[i] = bot;
+    fx.bars.prev_color[i] = color;
+}
 
-#if defined(CONFIG_VFX_OUTPUT_ST7735)
-                    uint16_t clear_x  = i * 3;
-                    uint16_t clear_cx = 3;
-                    uint16_t clear_u_y = 0;
-                    uint16_t clear_d_y = center_y + fft_out[i] + 2;
-                    uint16_t clear_cy  = center_y - fft_out[i];
-
-                    uint16_t fill_x  = i * 3;
-                    uint16_t fill_cx = 3;
-                    uint16_t fill_y  = center_y - fft_out[i];
-                    uint16_t fill_cy = fft_out[i] * 2 + 2;
-#else
-                    uint16_t clear_x  = i * 4;
-                    uint16_t clear_cx = 4;
-                    uint16_t clear_u_y = 0;
-                    uint16_t clear_d_y = center_y + fft_out[i] + 1;
-                    uint16_t clear_cy  = center_y - fft_out[i];
-
-                    uint16_t fill_x  = i * 4;
-                    uint16_t fill_cx = 4;
-                    uint16_t fill_y  = center_y - fft_out[i];
-                    uint16_t fill_cy = fft_out[i] * 2 + 1;
+// the drawing part of a bar frame starts once the heights are known
+static void vfx_bars_frame_start(void)
+{
+#ifdef CONFIG_VFX_BARS_BENCHMARK
+    fx.bars.bench_start = xthal_get_ccount();
 #endif
+}
 
-                    gdispGFillArea(vfx_gdisp, clear_x, clear_u_y, clear_cx, clear_cy, 0x000000);
-                    gdispGFillArea(vfx_gdisp, clear_x, clear_d_y, clear_cx, clear_cy, 0x000000);
-                    gdispGFillArea(vfx_gdisp, fill_x, fill_y, fill_cx, fill_cy, pixel_color);
-
-                    if ((color_h -= 8) == 7) {
-                        color_h = 511;
-                    }
-                }
-
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
-
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            fft_destroy(fft);
-
-            break;
+static void vfx_bars_frame_done(void)
+{
+    if (fx.bars.fb != NULL) {
+        if (fx.bars.dirty_y1 > fx.bars.dirty_y0) {
+            vfx_mark_dirty(fx.bars.dirty_y0, fx.bars.dirty_y1 - fx.bars.dirty_y0);
         }
-        case 0x12: {   // 音樂頻譜-电平-對數
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-#if defined(CONFIG_VFX_OUTPUT_ST7735)
-            const uint8_t vu_idx_min = 0;
-            const uint8_t vu_idx_max = 19;
-            const uint8_t vu_val_min = 0;
-            const uint8_t vu_val_max = 19;
-            const uint8_t vu_height = 4;
-            const uint8_t vu_width = 8;
-            const uint8_t vu_step = 9;
-#else
-            const uint8_t vu_idx_min = 0;
-            const uint8_t vu_idx_max = 23;
-            const uint8_t vu_val_min = 0;
-            const uint8_t vu_val_max = 26;
-            const uint8_t vu_height = 5;
-            const uint8_t vu_width = 10;
-            const uint8_t vu_step = 6;
-#endif
-            static int8_t vu_val_peak[24] = {0};
-            static int8_t vu_peak_delay[24] = {0};
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
-
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
-
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
-
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
-
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
-
-                    fft_execute(fft);
-
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+        fx.bars.fb = NULL;
+    }
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = 20 * log10(fft_amp[0]) / (65536 / vfx_disp_height) * vfx.scale_factor;
-                    if (fft_out[0] > vfx_disp_height) {
-                        fft_out[0] = vfx_disp_height;
-                    } else if (fft_out[0] < 0) {
-                        fft_out[0] = 0;
-                    }
+    if (fx.bars.pixels > fx.bars.pixels_max) {
+        fx.bars.pixels_max = fx.bars.pixels;
+    }
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = 20 * log10(fft_amp[k]) / (65536 / vfx_disp_height) * vfx.scale_factor;
-                        if (fft_out[k] > vfx_disp_height) {
-                            fft_out[k] = vfx_disp_height;
-                        } else if (fft_out[k] < 0) {
-                            fft_out[k] = 0;
-                        }
-                    }
-                }
+    fx.bars.pixels_sum += fx.bars.pixels;
 
-                for (uint8_t i=vu_idx_min; i<=vu_idx_max; i++) {
-                    int16_t vu_val_out = fft_out[i];
+#ifdef CONFIG_VFX_BARS_BENCHMARK
+    fx.bars.bench_cycles += xthal_get_ccount() - fx.bars.bench_start;
+    fx.bars.bench_pixels += fx.bars.pixels;
 
-                    if (vu_val_out > vu_val_max) {
-                        vu_val_out = vu_val_max;
-                    } else if (vu_val_out < vu_val_min) {
-                        vu_val_out = vu_val_min;
-                    }
+    if ((fx.bars.frames + 1) % BENCH_FRAMES == 0) {
+        ESP_LOGI(TAG, "bars: avg cycles/frame: %u, pixels/frame: %u",
+                 fx.bars.bench_cycles / BENCH_FRAMES, fx.bars.bench_pixels / BENCH_FRAMES);
 
-                    if (vu_peak_delay[i]-- == 0) {
-                        vu_peak_delay[i] = 2;
-                        vu_val_peak[i]--;
-                    }
-                    if (vu_val_peak[i] <= vu_val_out) {
-                        vu_val_peak[i] = vu_val_out;
-                    }
-                    if (vu_val_peak[i] != vu_val_out) {
-                        gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-vu_val_peak[i])*vu_height+1, vu_width-2, vu_height-2, 0x000000);
-                    }
-                    gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-vu_val_peak[i])*vu_height+1, vu_width-2, vu_height-2, 0xFF00FF);
+        fx.bars.bench_cycles = 0;
+        fx.bars.bench_pixels = 0;
+    }
+#endif
 
-                    color_h = 511;
-                    for (int8_t j=vu_val_max; j>=vu_val_min; j--) {
-                        uint32_t pixel_color = vfx_read_color_from_table(color_h, color_l);
+    fx.bars.pixels = 0;
+    fx.bars.frames++;
+}
 
-                        if (j == vu_val_peak[i]) {
-                            continue;
-                        }
+static void vfx_bars_start(bool log_scale, bool stereo)
+{
+    memset(&fx.bars, 0x00, sizeof(fx.bars));
 
-                        if (j > vu_val_out || ((j == 0) && (vu_val_out == 0))) { // Upside
-                            gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-j)*vu_height+1, vu_width-2, vu_height-2, 0x000000);
-                        } else { // Underside
-                            gdispGFillArea(vfx_gdisp, i*vu_width+1, (vu_val_max-j)*vu_height+1, vu_width-2, vu_height-2, pixel_color);
-                        }
+    fx.bars.log_scale = log_scale;
+    fx.bars.bar_num = vfx_disp_width / VFX_BAR_WIDTH;
+    fx.bars.center_y = vfx_disp_height % 2 ? vfx_disp_height / 2 : vfx_disp_height / 2 - 1;
+    fx.bars.half_max = vfx_disp_height / 2 - 1;
 
-                        color_h -= vu_step;
-                    }
-                }
+    gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
+    if (stereo) {
+        vfx_spectrum_start_stereo(fx.bars.bar_num);
+    } else {
+        vfx_spectrum_start(fx.bars.bar_num);
+    }
+}
 
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+static bool vfx_bars_lin_init(void)
+{
+    vfx_bars_start(false, false);
+    return true;
+}
 
-            fft_destroy(fft);
+static bool vfx_bars_log_init(void)
+{
+    vfx_bars_start(true, false);
+    return true;
+}
 
-            break;
-        }
-#else
-        // Light Cube Output
-        case VFX_MODE_IDX_RANDOM: {   // 隨機
-            vfx.mode = esp_random() % VFX_MODE_IDX_MAX;
+static bool vfx_bars_stereo_init(void)
+{
+    vfx_bars_start(true, true);
+    return true;
+}
 
-            break;
-        }
-        case VFX_MODE_IDX_RAINBOW: {   // 彩虹
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t z = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
+static void vfx_bars_teardown(void)
+{
+    vfx_spectrum_stop();
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    if (fx.bars.frames) {
+        ESP_LOGI(TAG, "pixels per frame: %u avg, %u max",
+                 (uint32_t)(fx.bars.pixels_sum / fx.bars.frames), fx.bars.pixels_max);
+    }
+}
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+static bool vfx_bars_gradual_render(uint32_t frame, uint32_t dt)   // 音樂頻譜-漸變-線性
+{
+    uint16_t color_tmp = 0;
+    uint16_t color_h = fx.bars.color_h;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out = fx.bars.fft_out[0];
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, NULL, false, vfx_disp_height, vfx.scale_factor, 1, vfx_disp_height);
+    vfx_bars_frame_start();
 
-                while (1) {
-                    vfx_draw_pixel(x, y, z, color_h, color_l);
-
-                    if (x++ == 7) {
-                        x = 0;
-                        if (y++ == 7) {
-                            y = 0;
-                            if (z++ == 7) {
-                                z = 0;
-                                break;
-                            }
-                        }
-                    }
+    color_tmp = color_h;
+    for (uint16_t i=0; i<fx.bars.bar_num; i++) {
+        uint32_t pixel_color = vfx_get_color(color_h, color_l);
 
-                    if (color_h++ == 511) {
-                        color_h = 0;
-                    }
-                }
+        vfx_bars_draw_span(i, vfx_disp_height - fft_out[i], vfx_disp_height, pixel_color);
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
-            break;
+        if (color_h++ == 511) {
+            color_h = 0;
         }
-        case VFX_MODE_IDX_RIBBON: {   // 彩帶
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint16_t color_tmp = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    if (color_tmp++ == 511) {
+        fx.bars.color_h = 0;
+    } else {
+        fx.bars.color_h = color_tmp;
+    }
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    vfx_bars_frame_done();
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+    return true;
+}
 
-                color_tmp = color_h;
-                while (1) {
-                    for (uint8_t i=0; i<8; i++) {
-                        vfx_draw_pixel(x, y, i, color_h, color_l);
-                    }
+static bool vfx_bars_rainbow_render(uint32_t frame, uint32_t dt)   // 音樂頻譜-彩虹-線性
+{
+    uint16_t color_h = 511;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out = fx.bars.fft_out[0];
 
-                    if (x++ == 7) {
-                        x = 0;
-                        if (y++ == 7) {
-                            y = 0;
-                            break;
-                        }
-                    }
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, NULL, false, vfx_disp_height, vfx.scale_factor, 1, vfx_disp_height);
+    vfx_bars_frame_start();
 
-                    if (color_h++ == 511) {
-                        color_h = 0;
-                    }
-                }
+    for (uint16_t i=0; i<fx.bars.bar_num; i++) {
+        uint32_t pixel_color = vfx_get_color(color_h, color_l);
 
-                if (color_tmp++ == 511) {
-                    color_h = 0;
-                } else {
-                    color_h = color_tmp;
-                }
+        vfx_bars_draw_span(i, vfx_disp_height - fft_out[i], vfx_disp_height, pixel_color);
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
-            break;
+        if ((color_h -= 8) == 7) {
+            color_h = 511;
         }
-        case VFX_MODE_IDX_GRADUAL: {   // 漸變
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    vfx_bars_frame_done();
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    return true;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+static bool vfx_vu_init(void)
+{
+    memset(&fx.bars, 0x00, sizeof(fx.bars));
 
-                vfx_fill_cube(0, 0, 0, 8, 8, 8, color_h, color_l);
+    fx.bars.log_scale = (vfx.mode == 0x12);
 
-                if (color_h++ == 511) {
-                    color_h = 0;
-                }
+    // nothing lit yet, the screen is black
+    for (uint16_t i=0; i<VFX_SPECTRUM_BANDS_MAX; i++) {
+        fx.bars.prev_top[i] = -1;
+        fx.bars.prev_bot[i] = -1;
+    }
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
-            break;
-        }
-        case VFX_MODE_IDX_BREATHING: {   // 呼吸
-            uint8_t scale_dir = 0;
-            uint16_t color_h = esp_random() % 512;
-            uint16_t color_l = 0;
+    gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    vfx_spectrum_start(vu_idx_max - vu_idx_min + 1);
+    vfx_bar_set_conf(&vu_bar_conf);
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    return true;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+// 0: off, 1: lit, 2: peak
+static uint8_t vfx_vu_state(int8_t j, int16_t out, int16_t peak)
+{
+    if (j == peak) {
+        return 2;
+    }
 
-                vfx_fill_cube(0, 0, 0, 8, 8, 8, color_h, color_l);
+    if (j > out || ((j == 0) && (out == 0))) {
+        return 0;
+    }
 
-                if (scale_dir == 0) {   // 暗->明
-                    if (color_l++ == vfx.lightness) {
-                        color_l = vfx.lightness;
-                        scale_dir = 1;
-                    }
-                } else {                // 明->暗
-                    if (color_l-- == 0) {
-                        color_l = 0;
-                        scale_dir = 0;
-                        color_h = esp_random() % 512;
-                    }
-                }
+    return 1;
+}
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
-            break;
+static bool vfx_vu_render(uint32_t frame, uint32_t dt)   // 音樂頻譜-电平
+{
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out = fx.bars.fft_out[0];
+    int16_t *vu_val_peak = fx.bars.peak;
+    // the last drawn level and peak of each column
+    int16_t *vu_prev_out = fx.bars.prev_top;
+    int16_t *vu_prev_peak = fx.bars.prev_bot;
+
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, vu_val_peak, fx.bars.log_scale, vfx_disp_height, vfx.scale_factor, vu_val_min, vu_val_max);
+    vfx_bars_frame_start();
+
+    for (uint8_t i=vu_idx_min; i<=vu_idx_max; i++) {
+        int16_t vu_val_out = fft_out[i];
+
+        if (vu_val_out == vu_prev_out[i] && vu_val_peak[i] == vu_prev_peak[i]) {
+            continue;
         }
-        case VFX_MODE_IDX_STAR_SKY_R: {   // 星空-紫紅
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t z = 0;
-            uint16_t led_num = 32;
-            uint16_t led_idx[512] = {0};
-            uint16_t color_h[512] = {0};
-            uint16_t color_l = vfx.lightness;
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            for (uint16_t i=0; i<=511; i++) {
-                led_idx[i] = i;
-                color_h[i] = i % 80;
-            }
+        for (int8_t j=vu_val_max; j>=vu_val_min; j--) {
+            uint8_t state = vfx_vu_state(j, vu_val_out, vu_val_peak[i]);
+            uint32_t pixel_color = 0x000000;
 
-            for (uint16_t i=0; i<=511; i++) {
-                uint16_t rnd = esp_random() % 512;
-                uint16_t tmp = led_idx[rnd];
-                led_idx[rnd] = led_idx[i];
-                led_idx[i] = tmp;
+            if (state == vfx_vu_state(j, vu_prev_out[i], vu_prev_peak[i])) {
+                continue;
             }
 
-            for (uint16_t i=0; i<=511; i++) {
-                uint16_t rnd = esp_random() % 512;
-                uint16_t tmp = color_h[rnd];
-                color_h[rnd] = color_h[i];
-                color_h[i] = tmp;
+            if (state == 2) {
+                pixel_color = Magenta;
+            } else if (state == 1) {
+                pixel_color = vfx_get_color(511 - (vu_val_max - j) * vu_step, color_l);
             }
 
-            int16_t idx_base = -led_num;
-            while (1) {
-                for (uint16_t i=0; i<=color_l; i++) {
-                    xLastWakeTime = xTaskGetTickCount();
-
-                    if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                        xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                        goto loop_break;
-                    }
-
-                    if (idx_base >= 0) {
-                        x = (led_idx[idx_base] % 64) % 8;
-                        y = (led_idx[idx_base] % 64) / 8;
-                        z = led_idx[idx_base] / 64;
-                        vfx_draw_pixel(x, y, z, color_h[idx_base], color_l - i);
-                    }
-
-                    if ((idx_base + led_num) <= 511) {
-                        x = (led_idx[idx_base + led_num] % 64) % 8;
-                        y = (led_idx[idx_base + led_num] % 64) / 8;
-                        z = led_idx[idx_base + led_num] / 64;
-                        vfx_draw_pixel(x, y, z, color_h[idx_base + led_num], i);
-                    }
-
-                    vTaskDelayUntil(&xLastWakeTime, 8 / portTICK_RATE_MS);
-                }
-
-                if (idx_base++ == 511) {
-                    idx_base = -led_num;
-                }
-            }
-            break;
+            vfx_bars_fill(i*vu_width+1, (vu_val_max-j)*vu_height+1, vu_width-2, vu_height-2, pixel_color);
         }
-        case VFX_MODE_IDX_STAR_SKY_G: {   // 星空-黃綠
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t z = 0;
-            uint16_t led_num = 32;
-            uint16_t led_idx[512] = {0};
-            uint16_t color_h[512] = {0};
-            uint16_t color_l = vfx.lightness;
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+        vu_prev_out[i] = vu_val_out;
+        vu_prev_peak[i] = vu_val_peak[i];
+    }
 
-            for (uint16_t i=0; i<=511; i++) {
-                led_idx[i] = i;
-                color_h[i] = i % 85 + 345;
-            }
+    vfx_bars_frame_done();
 
-            for (uint16_t i=0; i<=511; i++) {
-                uint16_t rnd = esp_random() % 512;
-                uint16_t tmp = led_idx[rnd];
-                led_idx[rnd] = led_idx[i];
-                led_idx[i] = tmp;
-            }
+    return true;
+}
 
-            for (uint16_t i=0; i<=511; i++) {
-                uint16_t rnd = esp_random() % 512;
-                uint16_t tmp = color_h[rnd];
-                color_h[rnd] = color_h[i];
-                color_h[i] = tmp;
-            }
+static void vfx_bars_draw_center(uint16_t i, int16_t height, uint32_t pixel_color)
+{
+    uint16_t center_y = fx.bars.center_y;
 
-            int16_t idx_base = -led_num;
-            while (1) {
-                for (uint16_t i=0; i<=color_l; i++) {
-                    xLastWakeTime = xTaskGetTickCount();
+#if defined(CONFIG_VFX_OUTPUT_ST7735)
+    vfx_bars_draw_span(i, center_y - height, center_y + height + 2, pixel_color);
+#else
+    vfx_bars_draw_span(i, center_y - height, center_y + height + 1, pixel_color);
+#endif
+}
 
-                    if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                        xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                        goto loop_break;
-                    }
+static bool vfx_bars_center_gradual_render(uint32_t frame, uint32_t dt)   // 音樂頻譜-漸變-對數
+{
+    uint16_t color_tmp = 0;
+    uint16_t color_h = fx.bars.color_h;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out = fx.bars.fft_out[0];
 
-                    if (idx_base >= 0) {
-                        x = (led_idx[idx_base] % 64) % 8;
-                        y = (led_idx[idx_base] % 64) / 8;
-                        z = led_idx[idx_base] / 64;
-                        vfx_draw_pixel(x, y, z, color_h[idx_base], color_l - i);
-                    }
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, NULL, true, vfx_disp_height, vfx.scale_factor, 0, fx.bars.center_y);
+    vfx_bars_frame_start();
 
-                    if ((idx_base + led_num) <= 511) {
-                        x = (led_idx[idx_base + led_num] % 64) % 8;
-                        y = (led_idx[idx_base + led_num] % 64) / 8;
-                        z = led_idx[idx_base + led_num] / 64;
-                        vfx_draw_pixel(x, y, z, color_h[idx_base + led_num], i);
-                    }
+    color_tmp = color_h;
+    for (uint16_t i=0; i<fx.bars.bar_num; i++) {
+        uint32_t pixel_color = vfx_get_color(color_h, color_l);
 
-                    vTaskDelayUntil(&xLastWakeTime, 8 / portTICK_RATE_MS);
-                }
+        vfx_bars_draw_center(i, fft_out[i], pixel_color);
 
-                if (idx_base++ == 511) {
-                    idx_base = -led_num;
-                }
-            }
-            break;
+        if (color_h++ == 511) {
+            color_h = 0;
         }
-        case VFX_MODE_IDX_STAR_SKY_B: {   // 星空-靑藍
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t z = 0;
-            uint16_t led_num = 32;
-            uint16_t led_idx[512] = {0};
-            uint16_t color_h[512] = {0};
-            uint16_t color_l = vfx.lightness;
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
-
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
-
-            for (uint16_t i=0; i<=511; i++) {
-                led_idx[i] = i;
-                color_h[i] = i % 80 + 170;
-            }
+    }
 
-            for (uint16_t i=0; i<=511; i++) {
-                uint16_t rnd = esp_random() % 512;
-                uint16_t tmp = led_idx[rnd];
-                led_idx[rnd] = led_idx[i];
-                led_idx[i] = tmp;
-            }
+    if (color_tmp++ == 511) {
+        fx.bars.color_h = 0;
+    } else {
+        fx.bars.color_h = color_tmp;
+    }
 
-            for (uint16_t i=0; i<=511; i++) {
-                uint16_t rnd = esp_random() % 512;
-                uint16_t tmp = color_h[rnd];
-                color_h[rnd] = color_h[i];
-                color_h[i] = tmp;
-            }
+    vfx_bars_frame_done();
 
-            int16_t idx_base = -led_num;
-            while (1) {
-                for (uint16_t i=0; i<=color_l; i++) {
-                    xLastWakeTime = xTaskGetTickCount();
+    return true;
+}
 
-                    if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                        xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                        goto loop_break;
-                    }
+static bool vfx_bars_center_rainbow_render(uint32_t frame, uint32_t dt)   // 音樂頻譜-彩虹-對數
+{
+    uint16_t color_h = 511;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out = fx.bars.fft_out[0];
 
-                    if (idx_base >= 0) {
-                        x = (led_idx[idx_base] % 64) % 8;
-                        y = (led_idx[idx_base] % 64) / 8;
-                        z = led_idx[idx_base] / 64;
-                        vfx_draw_pixel(x, y, z, color_h[idx_base], color_l - i);
-                    }
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, NULL, true, vfx_disp_height, vfx.scale_factor, 0, fx.bars.center_y);
+    vfx_bars_frame_start();
 
-                    if ((idx_base + led_num) <= 511) {
-                        x = (led_idx[idx_base + led_num] % 64) % 8;
-                        y = (led_idx[idx_base + led_num] % 64) / 8;
-                        z = led_idx[idx_base + led_num] / 64;
-                        vfx_draw_pixel(x, y, z, color_h[idx_base + led_num], i);
-                    }
+    for (uint16_t i=0; i<fx.bars.bar_num; i++) {
+        uint32_t pixel_color = vfx_get_color(color_h, color_l);
 
-                    vTaskDelayUntil(&xLastWakeTime, 8 / portTICK_RATE_MS);
-                }
+        vfx_bars_draw_center(i, fft_out[i], pixel_color);
 
-                if (idx_base++ == 511) {
-                    idx_base = -led_num;
-                }
-            }
-loop_break:
-            break;
+        if ((color_h -= 8) == 7) {
+            color_h = 511;
         }
-        case VFX_MODE_IDX_NUMBERS_S: {   // 數字-固定
-            uint16_t num = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    vfx_bars_frame_done();
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    return true;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+static bool vfx_bars_stereo_render(uint32_t frame, uint32_t dt)   // 音樂頻譜-立體聲-對數
+{
+    uint16_t color_h = 511;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out_l = fx.bars.fft_out[0];
+    int16_t *fft_out_r = fx.bars.fft_out[1];
+    // left channel grows up from the center line, right channel grows down
+    uint16_t center_y = fx.bars.center_y;
 
-                vfx_draw_layer_number(num, 2, color_h, color_l);
-                vfx_draw_layer_number(num, 3, color_h, color_l);
-                vfx_draw_layer_number(num, 4, color_h, color_l);
-                vfx_draw_layer_number(num, 5, color_h, color_l);
+    vfx_spectrum_update();
+    vfx_spectrum_get_stereo_height(fft_out_l, fft_out_r, true, vfx_disp_height, vfx.scale_factor, 0, fx.bars.half_max);
+    vfx_bars_frame_start();
 
-                if ((color_h += 8) == 512) {
-                    color_h = 0;
-                }
+    for (uint16_t i=0; i<fx.bars.bar_num; i++) {
+        uint32_t pixel_color = vfx_get_color(color_h, color_l);
 
-                if (num++ == 9) {
-                    num = 0;
-                }
+        vfx_bars_draw_span(i, center_y - fft_out_l[i], center_y + fft_out_r[i] + 2, pixel_color);
 
-                vTaskDelayUntil(&xLastWakeTime, 1000 / portTICK_RATE_MS);
-            }
-            break;
+        if ((color_h -= 8) == 7) {
+            color_h = 511;
         }
-        case VFX_MODE_IDX_NUMBERS_D: {   // 數字-滾動
-            uint16_t num = 0;
-            uint16_t layer0 = 0;
-            uint16_t layer1 = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    vfx_bars_frame_done();
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
-
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+    return true;
+}
 
-                for (uint8_t i=layer0; i<=layer1; i++) {
-                    vfx_draw_layer_number(num, i, color_h, color_l);
-                }
+static const vfx_effect_t vfx_effect[VFX_MODE_IDX_MAX] = {
+    [0x00] = { vfx_gif_init, vfx_gif_render, vfx_gif_teardown, 0 },
+    [0x01] = { vfx_gif_init, vfx_gif_render, vfx_gif_teardown, 0 },
+    [0x0D] = { vfx_bars_lin_init, vfx_bars_gradual_render, vfx_bars_teardown, 16 },
+    [0x0E] = { vfx_bars_lin_init, vfx_bars_rainbow_render, vfx_bars_teardown, 16 },
+    [0x0F] = { vfx_vu_init, vfx_vu_render, vfx_bars_teardown, 16 },
+    [0x10] = { vfx_bars_log_init, vfx_bars_center_gradual_render, vfx_bars_teardown, 16 },
+    [0x11] = { vfx_bars_log_init, vfx_bars_center_rainbow_render, vfx_bars_teardown, 16 },
+    [0x12] = { vfx_vu_init, vfx_vu_render, vfx_bars_teardown, 16 },
+    [0x13] = { vfx_bars_stereo_init, vfx_bars_stereo_render, vfx_bars_teardown, 16 },
+};
+#else
+// Light Cube Output
+static void vfx_spectrum_teardown(void)
+{
+    vfx_spectrum_stop();
+}
 
-                if (layer1 != 7 && layer0 != 0) {
-                    vfx_draw_layer_number(num, layer0, 0, 0);
+static bool vfx_rainbow_init(void)
+{
+    fx.rainbow.color_h = 0;
+    fx.rainbow.beat_count = 0;
 
-                    layer1++;
-                    layer0++;
-                } else if (layer1 == 7) {
-                    if (layer0++ == 7) {
-                        vfx_draw_layer_number(num, 7, 0, 0);
+    vfx_spectrum_start(8);
 
-                        layer0 = 0;
-                        layer1 = 0;
+    return true;
+}
 
-                        if (num++ == 9) {
-                            num = 0;
-                        }
-                    } else {
-                        vfx_draw_layer_number(num, layer0 - 1, 0, 0);
-                    }
-                } else {
-                    if ((layer1 - layer0) != 4) {
-                        layer1++;
-                    } else {
-                        vfx_draw_layer_number(num, 0, 0, 0);
-
-                        layer1++;
-                        layer0++;
-                    }
-                }
+static bool vfx_rainbow_render(uint32_t frame, uint32_t dt)   // 彩虹
+{
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint8_t z = 0;
+    uint16_t color_h = fx.rainbow.color_h;
+    uint16_t color_l = vfx.lightness;
+    const vfx_beat_t *beat = vfx_beat_get();
+
+    vfx_spectrum_update();
+
+    // turn the colour wheel by a quarter on every beat
+    if (beat->beat_count != fx.rainbow.beat_count) {
+        fx.rainbow.beat_count = beat->beat_count;
+        if (beat->confidence > VFX_BEAT_LOCKED) {
+            color_h = (color_h + 128) % 512;
+        }
+    }
 
-                if (color_h++ == 511) {
-                    color_h = 0;
+    while (1) {
+        vfx_draw_pixel(x, y, z, color_h, color_l);
+
+        if (x++ == 7) {
+            x = 0;
+            if (y++ == 7) {
+                y = 0;
+                if (z++ == 7) {
+                    z = 0;
+                    break;
                 }
-
-                vTaskDelayUntil(&xLastWakeTime, 80 / portTICK_RATE_MS);
             }
-            break;
         }
-        case VFX_MODE_IDX_MAGIC_CARPET: {   // 魔毯
-            uint16_t frame_idx = 0;
 
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
+        if (color_h++ == 511) {
+            color_h = 0;
+        }
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    fx.rainbow.color_h = color_h;
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    return true;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+static bool vfx_ribbon_init(void)
+{
+    fx.ribbon.color_h = 0;
 
-                vfx_draw_cube_bitmap(vfx_bitmap_wave[frame_idx], vfx.lightness);
+    return true;
+}
 
-                if (frame_idx++ == 44) {
-                    frame_idx = 8;
-                }
+static bool vfx_ribbon_render(uint32_t frame, uint32_t dt)   // 彩帶
+{
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint16_t color_tmp = 0;
+    uint16_t color_h = fx.ribbon.color_h;
+    uint16_t color_l = vfx.lightness;
+
+    color_tmp = color_h;
+    while (1) {
+        for (uint8_t i=0; i<8; i++) {
+            vfx_draw_pixel(x, y, i, color_h, color_l);
+        }
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
+        if (x++ == 7) {
+            x = 0;
+            if (y++ == 7) {
+                y = 0;
+                break;
             }
-            break;
         }
-        case VFX_MODE_IDX_ROTATING_F: {   // 旋轉曲面-正
-            uint16_t frame_pre = 0;
-            uint16_t frame_idx = 0;
 
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
+        if (color_h++ == 511) {
+            color_h = 0;
+        }
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    if (color_tmp++ == 511) {
+        fx.ribbon.color_h = 0;
+    } else {
+        fx.ribbon.color_h = color_tmp;
+    }
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    return true;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+static bool vfx_gradual_init(void)
+{
+    fx.gradual.color_h = 0;
 
-                frame_pre = frame_idx;
-                for (uint8_t i=0; i<8; i++) {
-                    vfx_draw_layer_bitmap(i, vfx_bitmap_line[frame_idx], vfx.lightness);
+    return true;
+}
 
-                    if (frame_idx++ == 27) {
-                        frame_idx = 0;
-                    }
-                }
+static bool vfx_gradual_render(uint32_t frame, uint32_t dt)   // 漸變
+{
+    vfx_fill_cube(0, 0, 0, 8, 8, 8, fx.gradual.color_h, vfx.lightness);
 
-                if (frame_pre++ == 27) {
-                    frame_idx = 0;
-                } else {
-                    frame_idx = frame_pre;
-                }
+    if (fx.gradual.color_h++ == 511) {
+        fx.gradual.color_h = 0;
+    }
 
-                vTaskDelayUntil(&xLastWakeTime, 40 / portTICK_RATE_MS);
-            }
-            break;
-        }
-        case VFX_MODE_IDX_ROTATING_B: {   // 旋轉曲面-反
-            uint16_t frame_pre = 0;
-            uint16_t frame_idx = 0;
+    return true;
+}
 
-            gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
+static bool vfx_breathing_init(void)
+{
+    fx.gradual.scale_dir = 0;
+    fx.gradual.color_h = esp_random() % 512;
+    fx.gradual.color_l = 0;
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    return true;
+}
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+static bool vfx_breathing_render(uint32_t frame, uint32_t dt)   // 呼吸
+{
+    vfx_fill_cube(0, 0, 0, 8, 8, 8, fx.gradual.color_h, fx.gradual.color_l);
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+    if (fx.gradual.scale_dir == 0) {   // 暗->明
+        if (fx.gradual.color_l++ == vfx.lightness) {
+            fx.gradual.color_l = vfx.lightness;
+            fx.gradual.scale_dir = 1;
+        }
+    } else {                // 明->暗
+        if (fx.gradual.color_l-- == 0) {
+            fx.gradual.color_l = 0;
+            fx.gradual.scale_dir = 0;
+            fx.gradual.color_h = esp_random() % 512;
+        }
+    }
 
-                frame_pre = frame_idx;
-                for (uint8_t i=0; i<8; i++) {
-                    vfx_draw_layer_bitmap(i, vfx_bitmap_line[frame_idx], vfx.lightness);
+    return true;
+}
 
-                    if (frame_idx-- == 0) {
-                        frame_idx = 27;
-                    }
-                }
+static void vfx_star_sky_start(uint16_t color_num, uint16_t color_base)
+{
+    fx.star_sky.led_num = 32;
 
-                if (frame_pre-- == 0) {
-                    frame_idx = 27;
-                } else {
-                    frame_idx = frame_pre;
-                }
+    vfx_voxel_clear();
 
-                vTaskDelayUntil(&xLastWakeTime, 40 / portTICK_RATE_MS);
-            }
-            break;
-        }
-        case VFX_MODE_IDX_FOUNTAIN_S_N: {   // 音樂噴泉-靜態-線性
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            const coord_t canvas_width = 64;
-            const coord_t canvas_height = 8;
+    for (uint16_t i=0; i<=511; i++) {
+        fx.star_sky.led_idx[i] = i;
+        fx.star_sky.color_h[i] = i % color_num + color_base;
+    }
 
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
+    for (uint16_t i=0; i<=511; i++) {
+        uint16_t rnd = esp_random() % 512;
+        uint16_t tmp = fx.star_sky.led_idx[rnd];
+        fx.star_sky.led_idx[rnd] = fx.star_sky.led_idx[i];
+        fx.star_sky.led_idx[i] = tmp;
+    }
 
-            gdispGFillArea(vfx_gdisp, 0, 0, canvas_width, canvas_height, 0x000000);
+    for (uint16_t i=0; i<=511; i++) {
+        uint16_t rnd = esp_random() % 512;
+        uint16_t tmp = fx.star_sky.color_h[rnd];
+        fx.star_sky.color_h[rnd] = fx.star_sky.color_h[i];
+        fx.star_sky.color_h[i] = tmp;
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    fx.star_sky.idx_base = -fx.star_sky.led_num;
+    fx.star_sky.step = 0;
+}
 
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
+static bool vfx_star_sky_r_init(void)   // 星空-紫紅
+{
+    vfx_star_sky_start(80, 0);
+    return true;
+}
 
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+static bool vfx_star_sky_g_init(void)   // 星空-黃綠
+{
+    vfx_star_sky_start(85, 345);
+    return true;
+}
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+static bool vfx_star_sky_b_init(void)   // 星空-靑藍
+{
+    vfx_star_sky_start(80, 170);
+    return true;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+static bool vfx_star_sky_render(uint32_t frame, uint32_t dt)
+{
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint8_t z = 0;
+    uint16_t led_num = fx.star_sky.led_num;
+    uint16_t *led_idx = fx.star_sky.led_idx;
+    uint16_t *color_h = fx.star_sky.color_h;
+    uint16_t color_l = vfx.lightness;
+    int16_t idx_base = fx.star_sky.idx_base;
+    uint16_t i = fx.star_sky.step;
+
+    // one star fades out while the next one fades in, a step per frame
+    if (idx_base >= 0) {
+        x = (led_idx[idx_base] % 64) % 8;
+        y = (led_idx[idx_base] % 64) / 8;
+        z = led_idx[idx_base] / 64;
+        vfx_draw_pixel(x, y, z, color_h[idx_base], color_l - i);
+    }
 
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
+    if ((idx_base + led_num) <= 511) {
+        x = (led_idx[idx_base + led_num] % 64) % 8;
+        y = (led_idx[idx_base + led_num] % 64) / 8;
+        z = led_idx[idx_base + led_num] / 64;
+        vfx_draw_pixel(x, y, z, color_h[idx_base + led_num], i);
+    }
 
-                    fft_execute(fft);
+    if (fx.star_sky.step++ == color_l) {
+        fx.star_sky.step = 0;
 
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+        if (fx.star_sky.idx_base++ == 511) {
+            fx.star_sky.idx_base = -led_num;
+        }
+    }
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = fft_amp[0] / (65536 / canvas_height) * vfx.scale_factor;
-                    if (fft_out[0] > canvas_height) {
-                        fft_out[0] = canvas_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
+    return true;
+}
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = fft_amp[k] / (65536 / canvas_height) * vfx.scale_factor;
-                        if (fft_out[k] > canvas_height) {
-                            fft_out[k] = canvas_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
-                    }
-                }
+static bool vfx_numbers_init(void)
+{
+    memset(&fx.numbers, 0x00, sizeof(fx.numbers));
 
-                color_h = 511;
-                for (uint16_t i=0; i<canvas_width; i++) {
-                    uint8_t clear_x  = x;
-                    uint8_t clear_cx = 1;
-                    uint8_t clear_y  = 7 - y;
-                    uint8_t clear_cy = 1;
-                    uint8_t clear_z  = 0;
-                    uint8_t clear_cz = canvas_height - fft_out[i];
-
-                    uint8_t fill_x  = x;
-                    uint8_t fill_cx = 1;
-                    uint8_t fill_y  = 7 - y;
-                    uint8_t fill_cy = 1;
-                    uint8_t fill_z  = canvas_height - fft_out[i];
-                    uint8_t fill_cz = fft_out[i];
-
-                    vfx_fill_cube(clear_x, clear_y, clear_z,
-                                  clear_cx, clear_cy, clear_cz,
-                                  0, 0);
-                    vfx_fill_cube(fill_x, fill_y, fill_z,
-                                  fill_cx, fill_cy, fill_cz,
-                                  color_h, color_l);
-
-                    if (y++ == 7) {
-                        y = 0;
-                        if (x++ == 7) {
-                            x = 0;
-                        }
-                    }
+    vfx_voxel_clear();
 
-                    if ((color_h -= 8) == 7) {
-                        color_h = 511;
-                    }
-                }
+    return true;
+}
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
+static bool vfx_numbers_s_render(uint32_t frame, uint32_t dt)   // 數字-固定
+{
+    uint16_t num = fx.numbers.num;
+    uint16_t color_h = fx.numbers.color_h;
+    uint16_t color_l = vfx.lightness;
 
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    vfx_draw_layer_number(num, 2, color_h, color_l);
+    vfx_voxel_copy_layer(VFX_AXIS_Y, 2, 3);
+    vfx_voxel_copy_layer(VFX_AXIS_Y, 2, 4);
+    vfx_voxel_copy_layer(VFX_AXIS_Y, 2, 5);
 
-            fft_destroy(fft);
+    if ((fx.numbers.color_h += 8) == 512) {
+        fx.numbers.color_h = 0;
+    }
 
-            break;
-        }
-        case VFX_MODE_IDX_FOUNTAIN_G_N: {   // 音樂噴泉-漸變-線性
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t  color_cnt = 0;
-            uint16_t color_tmp = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            const coord_t canvas_width = 64;
-            const coord_t canvas_height = 8;
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, canvas_width, canvas_height, 0x000000);
+    if (fx.numbers.num++ == 9) {
+        fx.numbers.num = 0;
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    return true;
+}
 
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
+static bool vfx_numbers_d_render(uint32_t frame, uint32_t dt)   // 數字-滾動
+{
+    // the number scrolls through along y, four layers thick, one layer per frame
+    vfx_voxel_shift(VFX_AXIS_Y, 1);
 
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    if (fx.numbers.step < 4) {
+        vfx_draw_layer_number(fx.numbers.num, 0, fx.numbers.color_h, vfx.lightness);
+    }
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    // it has left the cube after 12 frames
+    if (++fx.numbers.step == 12) {
+        fx.numbers.step = 0;
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+        if (fx.numbers.num++ == 9) {
+            fx.numbers.num = 0;
+        }
+    }
 
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
+    if (fx.numbers.color_h++ == 511) {
+        fx.numbers.color_h = 0;
+    }
 
-                    fft_execute(fft);
+    return true;
+}
 
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+static bool vfx_magic_carpet_init(void)
+{
+    fx.bitmap.frame_idx = 0;
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = fft_amp[0] / (65536 / canvas_height) * vfx.scale_factor;
-                    if (fft_out[0] > canvas_height) {
-                        fft_out[0] = canvas_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
+    vfx_voxel_clear();
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = fft_amp[k] / (65536 / canvas_height) * vfx.scale_factor;
-                        if (fft_out[k] > canvas_height) {
-                            fft_out[k] = canvas_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
-                    }
-                }
+    return true;
+}
 
-                color_h = color_tmp;
-                for (uint16_t i=0; i<canvas_width; i++) {
-                    uint8_t clear_x  = x;
-                    uint8_t clear_cx = 1;
-                    uint8_t clear_y  = 7 - y;
-                    uint8_t clear_cy = 1;
-                    uint8_t clear_z  = 0;
-                    uint8_t clear_cz = canvas_height - fft_out[i];
-
-                    uint8_t fill_x  = x;
-                    uint8_t fill_cx = 1;
-                    uint8_t fill_y  = 7 - y;
-                    uint8_t fill_cy = 1;
-                    uint8_t fill_z  = canvas_height - fft_out[i];
-                    uint8_t fill_cz = fft_out[i];
-
-                    vfx_fill_cube(clear_x, clear_y, clear_z,
-                                  clear_cx, clear_cy, clear_cz,
-                                  0, 0);
-                    vfx_fill_cube(fill_x, fill_y, fill_z,
-                                  fill_cx, fill_cy, fill_cz,
-                                  color_h, color_l);
-
-                    if (y++ == 7) {
-                        y = 0;
-                        if (x++ == 7) {
-                            x = 0;
-                        }
-                    }
+static bool vfx_magic_carpet_render(uint32_t frame, uint32_t dt)   // 魔毯
+{
+    vfx_draw_cube_bitmap(vfx_bitmap_wave[fx.bitmap.frame_idx], vfx.lightness);
 
-                    if ((color_h += 8) == 512) {
-                        color_h = 0;
-                    }
-                }
+    if (fx.bitmap.frame_idx++ == 44) {
+        fx.bitmap.frame_idx = 8;
+    }
 
-                if (color_cnt++ == 7) {
-                    color_cnt = 0;
-                    if ((color_tmp += 8) == 512) {
-                        color_tmp = 0;
-                    }
-                }
+    return true;
+}
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
+/* one line bitmap per layer, the hue runs along each layer and moves on by one per layer and per frame */
+static void vfx_rotating_draw(uint16_t frame_idx, int8_t dir)
+{
+    for (uint8_t k=0; k<sizeof(fx.bitmap.color)/sizeof(fx.bitmap.color[0]); k++) {
+        fx.bitmap.color[k] = vfx_get_color((fx.bitmap.color_h + k) % 512, vfx.lightness);
+    }
 
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    for (uint8_t i=0; i<8; i++) {
+        vfx_voxel_blit_layer(VFX_AXIS_Z, i, vfx_bitmap_line[frame_idx], &fx.bitmap.color[i], 1);
 
-            fft_destroy(fft);
+        frame_idx = (frame_idx + 28 + dir) % 28;
+    }
 
-            break;
-        }
-        case VFX_MODE_IDX_FOUNTAIN_H_N: {   // 音樂噴泉-螺旋-線性
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t color_flg = 0;
-            uint8_t color_cnt = 0;
-            uint16_t color_h[64] = {0};
-            uint16_t color_l[64] = {vfx.lightness};
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            const uint8_t led_idx_table[][64] = {
-                {
-                    3, 4, 4, 3, 2, 2, 2, 3, 4, 5, 5, 5, 5, 4, 3, 2,
-                    1, 1, 1, 1, 1, 2, 3, 4, 5, 6, 6, 6, 6, 6, 6, 5,
-                    4, 3, 2, 1, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5,
-                    6, 7, 7, 7, 7, 7, 7, 7, 7, 6, 5, 4, 3, 2, 1, 0,
-                },
-                {
-                    3, 3, 4, 4, 4, 3, 2, 2, 2, 2, 3, 4, 5, 5, 5, 5,
-                    5, 4, 3, 2, 1, 1, 1, 1, 1, 1, 2, 3, 4, 5, 6, 6,
-                    6, 6, 6, 6, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0, 0,
-                    0, 0, 1, 2, 3, 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7,
-                }
-            };
-            const coord_t canvas_width = 64;
-            const coord_t canvas_height = 8;
+    fx.bitmap.color_h = (fx.bitmap.color_h + 8) % 512;
+}
 
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
+static bool vfx_rotating_init(void)
+{
+    fx.bitmap.frame_idx = 0;
+    fx.bitmap.color_h = 0;
 
-            gdispGFillArea(vfx_gdisp, 0, 0, canvas_width, canvas_height, 0x000000);
+    vfx_voxel_clear();
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    vfx_spectrum_start(8);
 
-            for (uint16_t i=0; i<64; i++) {
-                color_h[i] = i * 8;
-                color_l[i] = vfx.lightness;
-            }
+    return true;
+}
 
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
+static bool vfx_rotating_f_render(uint32_t frame, uint32_t dt)   // 旋轉曲面-正
+{
+    uint16_t frame_pre = 0;
+    uint16_t frame_idx = fx.bitmap.frame_idx;
+    const vfx_beat_t *beat = vfx_beat_get();
 
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    vfx_spectrum_update();
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    // one turn every two beats once the tempo is locked, free running otherwise
+    if (beat->confidence > VFX_BEAT_LOCKED) {
+        frame_idx = ((beat->beat_count % 2) + beat->phase) * 14;
+    }
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+    frame_pre = frame_idx;
+    vfx_rotating_draw(frame_idx, 1);
 
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
+    if (frame_pre++ == 27) {
+        fx.bitmap.frame_idx = 0;
+    } else {
+        fx.bitmap.frame_idx = frame_pre;
+    }
 
-                    fft_execute(fft);
+    return true;
+}
 
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+static bool vfx_rotating_b_render(uint32_t frame, uint32_t dt)   // 旋轉曲面-反
+{
+    uint16_t frame_pre = 0;
+    uint16_t frame_idx = fx.bitmap.frame_idx;
+    const vfx_beat_t *beat = vfx_beat_get();
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = fft_amp[0] / (65536 / canvas_height) * vfx.scale_factor;
-                    if (fft_out[0] > canvas_height) {
-                        fft_out[0] = canvas_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
+    vfx_spectrum_update();
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = fft_amp[k] / (65536 / canvas_height) * vfx.scale_factor;
-                        if (fft_out[k] > canvas_height) {
-                            fft_out[k] = canvas_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
-                    }
-                }
+    // one turn every two beats once the tempo is locked, free running otherwise
+    if (beat->confidence > VFX_BEAT_LOCKED) {
+        frame_idx = 27 - (uint16_t)(((beat->beat_count % 2) + beat->phase) * 14);
+    }
 
-                for (uint16_t i=0; i<canvas_width; i++) {
-                    x = led_idx_table[0][i];
-                    y = led_idx_table[1][i];
-
-                    uint8_t clear_x  = x;
-                    uint8_t clear_cx = 1;
-                    uint8_t clear_y  = 7 - y;
-                    uint8_t clear_cy = 1;
-                    uint8_t clear_z  = 0;
-                    uint8_t clear_cz = canvas_height - fft_out[i];
-
-                    uint8_t fill_x  = x;
-                    uint8_t fill_cx = 1;
-                    uint8_t fill_y  = 7 - y;
-                    uint8_t fill_cy = 1;
-                    uint8_t fill_z  = canvas_height - fft_out[i];
-                    uint8_t fill_cz = fft_out[i];
-
-                    vfx_fill_cube(clear_x, clear_y, clear_z,
-                                  clear_cx, clear_cy, clear_cz,
-                                  0, 0);
-                    vfx_fill_cube(fill_x, fill_y, fill_z,
-                                  fill_cx, fill_cy, fill_cz,
-                                  color_h[i], color_l[i]);
-
-                    if (color_flg) {
-                        if (color_h[i]-- == 0) {
-                            color_h[i] = 511;
-                        }
-                    }
-                }
+    frame_pre = frame_idx;
+    vfx_rotating_draw(frame_idx, -1);
 
-                if (color_cnt++ == 1) {
-                    color_cnt = 0;
-                    color_flg = 1;
-                } else {
-                    color_flg = 0;
-                }
+    if (frame_pre-- == 0) {
+        fx.bitmap.frame_idx = 27;
+    } else {
+        fx.bitmap.frame_idx = frame_pre;
+    }
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
+    return true;
+}
 
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+static void vfx_fountain_start(bool log_scale, bool stereo)
+{
+    memset(&fx.fountain, 0x00, sizeof(fx.fountain));
 
-            fft_destroy(fft);
+    fx.fountain.log_scale = log_scale;
 
-            break;
-        }
-        case VFX_MODE_IDX_FOUNTAIN_S_L: {   // 音樂噴泉-靜態-對數
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            const coord_t canvas_width = 64;
-            const coord_t canvas_height = 8;
+    vfx_voxel_clear();
 
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
+    if (stereo) {
+        // one column per band on the left (x = 0) and right (x = 7) faces
+        vfx_spectrum_start_stereo(8);
+    } else {
+        vfx_spectrum_start(canvas_width);
+    }
+}
 
-            gdispGFillArea(vfx_gdisp, 0, 0, canvas_width, canvas_height, 0x000000);
+static bool vfx_fountain_lin_init(void)
+{
+    vfx_fountain_start(false, false);
+    return true;
+}
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+static bool vfx_fountain_log_init(void)
+{
+    vfx_fountain_start(true, false);
+    return true;
+}
 
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
+static bool vfx_fountain_h_lin_init(void)
+{
+    vfx_fountain_start(false, false);
 
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    for (uint16_t i=0; i<64; i++) {
+        fx.fountain.color_h[i] = i * 8;
+        fx.fountain.color_l[i] = vfx.lightness;
+    }
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    return true;
+}
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+static bool vfx_fountain_h_log_init(void)
+{
+    vfx_fountain_h_lin_init();
 
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
+    fx.fountain.log_scale = true;
 
-                    fft_execute(fft);
+    return true;
+}
 
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+static bool vfx_fountain_stereo_init(void)
+{
+    vfx_fountain_start(true, true);
+    return true;
+}
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = 20 * log10(fft_amp[0]) / (65536 / canvas_height) * vfx.scale_factor;
-                    if (fft_out[0] > canvas_height) {
-                        fft_out[0] = canvas_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
+static void vfx_fountain_draw_column(uint8_t x, uint8_t y, int16_t height, uint16_t color_h, uint16_t color_l)
+{
+    uint8_t clear_x  = x;
+    uint8_t clear_cx = 1;
+    uint8_t clear_y  = 7 - y;
+    uint8_t clear_cy = 1;
+    uint8_t clear_z  = 0;
+    uint8_t clear_cz = canvas_height - height;
+
+    uint8_t fill_x  = x;
+    uint8_t fill_cx = 1;
+    uint8_t fill_y  = 7 - y;
+    uint8_t fill_cy = 1;
+    uint8_t fill_z  = canvas_height - height;
+    uint8_t fill_cz = height;
+
+    vfx_fill_cube(clear_x, clear_y, clear_z,
+                  clear_cx, clear_cy, clear_cz,
+                  0, 0);
+    vfx_fill_cube(fill_x, fill_y, fill_z,
+                  fill_cx, fill_cy, fill_cz,
+                  color_h, color_l);
+}
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = 20 * log10(fft_amp[k]) / (65536 / canvas_height) * vfx.scale_factor;
-                        if (fft_out[k] > canvas_height) {
-                            fft_out[k] = canvas_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
-                    }
-                }
+static bool vfx_fountain_s_render(uint32_t frame, uint32_t dt)   // 音樂噴泉-靜態
+{
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint16_t color_h = 511;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out = fx.fountain.fft_out[0];
+
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, NULL, fx.fountain.log_scale, canvas_height, vfx.scale_factor, 1, canvas_height);
+
+    for (uint16_t i=0; i<canvas_width; i++) {
+        vfx_fountain_draw_column(x, y, fft_out[i], color_h, color_l);
+
+        if (y++ == 7) {
+            y = 0;
+            if (x++ == 7) {
+                x = 0;
+            }
+        }
 
-                color_h = 511;
-                for (uint16_t i=0; i<canvas_width; i++) {
-                    uint8_t clear_x  = x;
-                    uint8_t clear_cx = 1;
-                    uint8_t clear_y  = 7 - y;
-                    uint8_t clear_cy = 1;
-                    uint8_t clear_z  = 0;
-                    uint8_t clear_cz = canvas_height - fft_out[i];
-
-                    uint8_t fill_x  = x;
-                    uint8_t fill_cx = 1;
-                    uint8_t fill_y  = 7 - y;
-                    uint8_t fill_cy = 1;
-                    uint8_t fill_z  = canvas_height - fft_out[i];
-                    uint8_t fill_cz = fft_out[i];
-
-                    vfx_fill_cube(clear_x, clear_y, clear_z,
-                                  clear_cx, clear_cy, clear_cz,
-                                  0, 0);
-                    vfx_fill_cube(fill_x, fill_y, fill_z,
-                                  fill_cx, fill_cy, fill_cz,
-                                  color_h, color_l);
-
-                    if (y++ == 7) {
-                        y = 0;
-                        if (x++ == 7) {
-                            x = 0;
-                        }
-                    }
+        if ((color_h -= 8) == 7) {
+            color_h = 511;
+        }
+    }
 
-                    if ((color_h -= 8) == 7) {
-                        color_h = 511;
-                    }
-                }
+    return true;
+}
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
+static bool vfx_fountain_g_render(uint32_t frame, uint32_t dt)   // 音樂噴泉-漸變
+{
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint16_t color_h = fx.fountain.color_tmp;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out = fx.fountain.fft_out[0];
+
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, NULL, fx.fountain.log_scale, canvas_height, vfx.scale_factor, 1, canvas_height);
+
+    for (uint16_t i=0; i<canvas_width; i++) {
+        vfx_fountain_draw_column(x, y, fft_out[i], color_h, color_l);
+
+        if (y++ == 7) {
+            y = 0;
+            if (x++ == 7) {
+                x = 0;
             }
+        }
 
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
-
-            fft_destroy(fft);
+        if ((color_h += 8) == 512) {
+            color_h = 0;
+        }
+    }
 
-            break;
+    if (fx.fountain.color_cnt++ == 7) {
+        fx.fountain.color_cnt = 0;
+        if ((fx.fountain.color_tmp += 8) == 512) {
+            fx.fountain.color_tmp = 0;
         }
-        case VFX_MODE_IDX_FOUNTAIN_G_L: {   // 音樂噴泉-漸變-對數
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t  color_cnt = 0;
-            uint16_t color_tmp = 0;
-            uint16_t color_h = 0;
-            uint16_t color_l = vfx.lightness;
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            const coord_t canvas_width = 64;
-            const coord_t canvas_height = 8;
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, canvas_width, canvas_height, 0x000000);
+    }
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+    return true;
+}
 
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
+static bool vfx_fountain_h_render(uint32_t frame, uint32_t dt)   // 音樂噴泉-螺旋
+{
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint16_t *color_h = fx.fountain.color_h;
+    uint16_t *color_l = fx.fountain.color_l;
+    int16_t *fft_out = fx.fountain.fft_out[0];
 
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    vfx_spectrum_update();
+    vfx_spectrum_get_height(fft_out, NULL, fx.fountain.log_scale, canvas_height, vfx.scale_factor, 1, canvas_height);
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+    for (uint16_t i=0; i<canvas_width; i++) {
+        x = vfx_fountain_h_table[0][i];
+        y = vfx_fountain_h_table[1][i];
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+        vfx_fountain_draw_column(x, y, fft_out[i], color_h[i], color_l[i]);
 
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
+        if (fx.fountain.color_flg) {
+            if (color_h[i]-- == 0) {
+                color_h[i] = 511;
+            }
+        }
+    }
 
-                    fft_execute(fft);
+    if (fx.fountain.color_cnt++ == 1) {
+        fx.fountain.color_cnt = 0;
+        fx.fountain.color_flg = 1;
+    } else {
+        fx.fountain.color_flg = 0;
+    }
 
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+    return true;
+}
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = 20 * log10(fft_amp[0]) / (65536 / canvas_height) * vfx.scale_factor;
-                    if (fft_out[0] > canvas_height) {
-                        fft_out[0] = canvas_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
+static bool vfx_fountain_stereo_render(uint32_t frame, uint32_t dt)   // 音樂噴泉-立體聲-對數
+{
+    uint16_t color_h = 511;
+    uint16_t color_l = vfx.lightness;
+    int16_t *fft_out_l = fx.fountain.fft_out[0];
+    int16_t *fft_out_r = fx.fountain.fft_out[1];
+
+    vfx_spectrum_update();
+    vfx_spectrum_get_stereo_height(fft_out_l, fft_out_r, true, canvas_height, vfx.scale_factor, 1, canvas_height);
+
+    for (uint8_t i=0; i<8; i++) {
+        uint8_t y = 7 - i;
+
+        vfx_fill_cube(0, y, 0,
+                      1, 1, canvas_height - fft_out_l[i],
+                      0, 0);
+        vfx_fill_cube(0, y, canvas_height - fft_out_l[i],
+                      1, 1, fft_out_l[i],
+                      color_h, color_l);
+
+        vfx_fill_cube(7, y, 0,
+                      1, 1, canvas_height - fft_out_r[i],
+                      0, 0);
+        vfx_fill_cube(7, y, canvas_height - fft_out_r[i],
+                      1, 1, fft_out_r[i],
+                      color_h, color_l);
+
+        color_h -= 64;
+    }
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = 20 * log10(fft_amp[k]) / (65536 / canvas_height) * vfx.scale_factor;
-                        if (fft_out[k] > canvas_height) {
-                            fft_out[k] = canvas_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
-                    }
-                }
+    return true;
+}
 
-                color_h = color_tmp;
-                for (uint16_t i=0; i<canvas_width; i++) {
-                    uint8_t clear_x  = x;
-                    uint8_t clear_cx = 1;
-                    uint8_t clear_y  = 7 - y;
-                    uint8_t clear_cy = 1;
-                    uint8_t clear_z  = 0;
-                    uint8_t clear_cz = canvas_height - fft_out[i];
-
-                    uint8_t fill_x  = x;
-                    uint8_t fill_cx = 1;
-                    uint8_t fill_y  = 7 - y;
-                    uint8_t fill_cy = 1;
-                    uint8_t fill_z  = canvas_height - fft_out[i];
-                    uint8_t fill_cz = fft_out[i];
-
-                    vfx_fill_cube(clear_x, clear_y, clear_z,
-                                  clear_cx, clear_cy, clear_cz,
-                                  0, 0);
-                    vfx_fill_cube(fill_x, fill_y, fill_z,
-                                  fill_cx, fill_cy, fill_cz,
-                                  color_h, color_l);
-
-                    if (y++ == 7) {
-                        y = 0;
-                        if (x++ == 7) {
-                            x = 0;
-                        }
-                    }
+static const vfx_effect_t vfx_effect[VFX_MODE_IDX_MAX] = {
+    [VFX_MODE_IDX_RAINBOW]         = { vfx_rainbow_init, vfx_rainbow_render, vfx_spectrum_teardown, 16 },
+    [VFX_MODE_IDX_RIBBON]          = { vfx_ribbon_init, vfx_ribbon_render, NULL, 16 },
+    [VFX_MODE_IDX_GRADUAL]         = { vfx_gradual_init, vfx_gradual_render, NULL, 16 },
+    [VFX_MODE_IDX_BREATHING]       = { vfx_breathing_init, vfx_breathing_render, NULL, 16 },
+    [VFX_MODE_IDX_STAR_SKY_R]      = { vfx_star_sky_r_init, vfx_star_sky_render, NULL, 8 },
+    [VFX_MODE_IDX_STAR_SKY_G]      = { vfx_star_sky_g_init, vfx_star_sky_render, NULL, 8 },
+    [VFX_MODE_IDX_STAR_SKY_B]      = { vfx_star_sky_b_init, vfx_star_sky_render, NULL, 8 },
+    [VFX_MODE_IDX_NUMBERS_S]       = { vfx_numbers_init, vfx_numbers_s_render, NULL, 1000 },
+    [VFX_MODE_IDX_NUMBERS_D]       = { vfx_numbers_init, vfx_numbers_d_render, NULL, 80 },
+    [VFX_MODE_IDX_MAGIC_CARPET]    = { vfx_magic_carpet_init, vfx_magic_carpet_render, NULL, 16 },
+    [VFX_MODE_IDX_ROTATING_F]      = { vfx_rotating_init, vfx_rotating_f_render, vfx_spectrum_teardown, 40 },
+    [VFX_MODE_IDX_ROTATING_B]      = { vfx_rotating_init, vfx_rotating_b_render, vfx_spectrum_teardown, 40 },
+    [VFX_MODE_IDX_FOUNTAIN_S_N]    = { vfx_fountain_lin_init, vfx_fountain_s_render, vfx_spectrum_teardown, 16 },
+    [VFX_MODE_IDX_FOUNTAIN_G_N]    = { vfx_fountain_lin_init, vfx_fountain_g_render, vfx_spectrum_teardown, 16 },
+    [VFX_MODE_IDX_FOUNTAIN_H_N]    = { vfx_fountain_h_lin_init, vfx_fountain_h_render, vfx_spectrum_teardown, 16 },
+    [VFX_MODE_IDX_FOUNTAIN_S_L]    = { vfx_fountain_log_init, vfx_fountain_s_render, vfx_spectrum_teardown, 16 },
+    [VFX_MODE_IDX_FOUNTAIN_G_L]    = { vfx_fountain_log_init, vfx_fountain_g_render, vfx_spectrum_teardown, 16 },
+    [VFX_MODE_IDX_FOUNTAIN_H_L]    = { vfx_fountain_h_log_init, vfx_fountain_h_render, vfx_spectrum_teardown, 16 },
+    [VFX_MODE_IDX_FOUNTAIN_STEREO] = { vfx_fountain_stereo_init, vfx_fountain_stereo_render, vfx_spectrum_teardown, 16 },
+};
+#endif // CONFIG_SCREEN_PANEL_OUTPUT_VFX
 
-                    if ((color_h += 8) == 512) {
-                        color_h = 0;
-                    }
-                }
+static void vfx_run_effect(const vfx_effect_t *effect)
+{
+    uint32_t frame = 0;
+    uint32_t missed = 0;
+    uint16_t miss_cnt = 0;
+    uint16_t slack_cnt = 0;
+    int64_t frame_time = esp_timer_get_time();
+    portTickType xLastWakeTime;
 
-                if (color_cnt++ == 7) {
-                    color_cnt = 0;
-                    if ((color_tmp += 8) == 512) {
-                        color_tmp = 0;
-                    }
-                }
+    vfx_set_frame_period(effect->period);
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
+    gdispGSetBacklight(vfx_gdisp, vfx.backlight);
 
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    if (effect->init && !effect->init()) {
+        return;
+    }
 
-            fft_destroy(fft);
+    xLastWakeTime = xTaskGetTickCount();
 
+    while (1) {
+        if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
+            xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
             break;
         }
-        case VFX_MODE_IDX_FOUNTAIN_H_L: {   // 音樂噴泉-螺旋-對數
-            uint8_t x = 0;
-            uint8_t y = 0;
-            uint8_t color_flg = 0;
-            uint8_t color_cnt = 0;
-            uint16_t color_h[64] = {0};
-            uint16_t color_l[64] = {vfx.lightness};
-            fft_config_t *fft = NULL;
-            float   fft_amp[64] = {0};
-            int16_t fft_out[64] = {0};
-            const uint8_t led_idx_table[][64] = {
-                {
-                    3, 4, 4, 3, 2, 2, 2, 3, 4, 5, 5, 5, 5, 4, 3, 2,
-                    1, 1, 1, 1, 1, 2, 3, 4, 5, 6, 6, 6, 6, 6, 6, 5,
-                    4, 3, 2, 1, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5,
-                    6, 7, 7, 7, 7, 7, 7, 7, 7, 6, 5, 4, 3, 2, 1, 0,
-                },
-                {
-                    3, 3, 4, 4, 4, 3, 2, 2, 2, 2, 3, 4, 5, 5, 5, 5,
-                    5, 4, 3, 2, 1, 1, 1, 1, 1, 1, 2, 3, 4, 5, 6, 6,
-                    6, 6, 6, 6, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0, 0,
-                    0, 0, 1, 2, 3, 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7,
-                }
-            };
-            const coord_t canvas_width = 64;
-            const coord_t canvas_height = 8;
-
-            xEventGroupClearBits(user_event_group, VFX_FFT_NULL_BIT);
-
-            gdispGFillArea(vfx_gdisp, 0, 0, canvas_width, canvas_height, 0x000000);
 
-            gdispGSetBacklight(vfx_gdisp, vfx.backlight);
+        int64_t now = esp_timer_get_time();
+        uint32_t dt = (now - frame_time) / 1000;
+        frame_time = now;
 
-            for (uint16_t i=0; i<64; i++) {
-                color_h[i] = i * 8;
-                color_l[i] = vfx.lightness;
-            }
+        bool running = effect->render(frame++, dt);
 
-            memset(vfx_fft_input, 0x00, sizeof(vfx_fft_input));
-            fft = fft_init(FFT_N, FFT_REAL, FFT_FORWARD, vfx_fft_input, vfx_fft_output);
+#ifndef CONFIG_SCREEN_PANEL_OUTPUT_VFX
+        vfx_voxel_present();
+#endif
 
-            xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+#ifdef CONFIG_SCREEN_PANEL_TE_SYNC
+        // the flush waits for the panel V-blank, that is pacing rather than work
+        int64_t busy = esp_timer_get_time() - now;
+#endif
 
-            while (1) {
-                xLastWakeTime = xTaskGetTickCount();
+        gdispGFlush(vfx_gdisp);
 
-                if (xEventGroupGetBits(user_event_group) & VFX_RELOAD_BIT) {
-                    xEventGroupClearBits(user_event_group, VFX_RELOAD_BIT);
-                    break;
-                }
+        if (!running) {
+            break;
+        }
 
-                if (!(xEventGroupGetBits(user_event_group) & VFX_FFT_NULL_BIT)) {
+#ifndef CONFIG_SCREEN_PANEL_TE_SYNC
+        // render and flush time against the frame deadline
+        int64_t busy = esp_timer_get_time() - now;
+#endif
 
-                    fft_execute(fft);
+        if (vfx_frame_nominal && busy > vfx_frame_period * 1000) {
+            missed++;
+            slack_cnt = 0;
 
-                    xEventGroupSetBits(user_event_group, VFX_FFT_NULL_BIT);
+            // keep missing, lower the frame rate down to half the requested one
+            if (++miss_cnt == VFX_FRAME_MISS_MAX) {
+                miss_cnt = 0;
+                if (vfx_frame_period < vfx_frame_nominal * 2) {
+                    vfx_frame_period += vfx_frame_period / 4 + 1;
+                    ESP_LOGW(TAG, "frame period: %u ms", vfx_frame_period);
+                }
+            }
 
-                    fft_amp[0] = sqrt(pow(vfx_fft_output[0], 2) + pow(vfx_fft_output[1], 2)) / FFT_N;
-                    fft_out[0] = 20 * log10(fft_amp[0]) / (65536 / canvas_height) * vfx.scale_factor;
-                    if (fft_out[0] > canvas_height) {
-                        fft_out[0] = canvas_height;
-                    } else if (fft_out[0] < 1) {
-                        fft_out[0] = 1;
-                    }
+            // start over from now instead of rushing the frames that are late
+            xLastWakeTime = xTaskGetTickCount();
+            vTaskDelay(1);
+        } else {
+            miss_cnt = 0;
 
-                    for (uint16_t k=1; k<FFT_N/2; k++) {
-                        fft_amp[k] = sqrt(pow(vfx_fft_output[2*k], 2) + pow(vfx_fft_output[2*k+1], 2)) / FFT_N * 2;
-                        fft_out[k] = 20 * log10(fft_amp[k]) / (65536 / canvas_height) * vfx.scale_factor;
-                        if (fft_out[k] > canvas_height) {
-                            fft_out[k] = canvas_height;
-                        } else if (fft_out[k] < 1) {
-                            fft_out[k] = 1;
-                        }
+            // plenty of time left, speed back up towards the requested rate
+            if (vfx_frame_period > vfx_frame_nominal && busy < vfx_frame_period * 500) {
+                if (++slack_cnt == VFX_FRAME_SLACK_MIN) {
+                    slack_cnt = 0;
+                    vfx_frame_period -= vfx_frame_period / 8 + 1;
+                    if (vfx_frame_period < vfx_frame_nominal) {
+                        vfx_frame_period = vfx_frame_nominal;
                     }
                 }
+            } else {
+                slack_cnt = 0;
+            }
 
-                for (uint16_t i=0; i<canvas_width; i++) {
-                    x = led_idx_table[0][i];
-                    y = led_idx_table[1][i];
-
-                    uint8_t clear_x  = x;
-                    uint8_t clear_cx = 1;
-                    uint8_t clear_y  = 7 - y;
-                    uint8_t clear_cy = 1;
-                    uint8_t clear_z  = 0;
-                    uint8_t clear_cz = canvas_height - fft_out[i];
-
-                    uint8_t fill_x  = x;
-                    uint8_t fill_cx = 1;
-                    uint8_t fill_y  = 7 - y;
-                    uint8_t fill_cy = 1;
-                    uint8_t fill_z  = canvas_height - fft_out[i];
-                    uint8_t fill_cz = fft_out[i];
-
-                    vfx_fill_cube(clear_x, clear_y, clear_z,
-                                  clear_cx, clear_cy, clear_cz,
-                                  0, 0);
-                    vfx_fill_cube(fill_x, fill_y, fill_z,
-                                  fill_cx, fill_cy, fill_cz,
-                                  color_h[i], color_l[i]);
-
-                    if (color_flg) {
-                        if (color_h[i]-- == 0) {
-                            color_h[i] = 511;
-                        }
-                    }
-                }
+            // a zero increment would trip the assert in vTaskDelayUntil()
+            if (vfx_frame_period >= portTICK_RATE_MS) {
+                vTaskDelayUntil(&xLastWakeTime, vfx_frame_period / portTICK_RATE_MS);
+            } else {
+                xLastWakeTime = xTaskGetTickCount();
+                taskYIELD();
+            }
+        }
+    }
 
-                if (color_cnt++ == 1) {
-                    color_cnt = 0;
-                    color_flg = 1;
-                } else {
-                    color_flg = 0;
-                }
+    if (effect->teardown) {
+        effect->teardown();
+    }
 
-                vTaskDelayUntil(&xLastWakeTime, 16 / portTICK_RATE_MS);
-            }
+    ESP_LOGI(TAG, "frames: %u, missed: %u, period: %u ms", frame, missed, vfx_frame_period);
+}
+
+static void vfx_task(void *pvParameter)
+{
+    gfxInit();
 
-            xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+    vfx_gdisp = gdispGetDisplay(0);
+    vfx_disp_width = gdispGGetWidth(vfx_gdisp);
+    vfx_disp_height = gdispGGetHeight(vfx_gdisp);
 
-            fft_destroy(fft);
+    ESP_LOGI(TAG, "started.");
 
-            break;
+    while (1) {
+#ifndef CONFIG_SCREEN_PANEL_OUTPUT_VFX
+        while (vfx.mode == VFX_MODE_IDX_RANDOM) {   // 隨機
+            vfx.mode = esp_random() % VFX_MODE_IDX_MAX;
         }
-#endif // CONFIG_SCREEN_PANEL_OUTPUT_VFX
-        case VFX_MODE_IDX_PAUSE:
+#endif
+
+        if (vfx.mode == VFX_MODE_IDX_PAUSE) {
             gdispGSetBacklight(vfx_gdisp, vfx.backlight);
 
             xEventGroupWaitBits(
@@ -1950,15 +1409,20 @@ loop_break:
                 pdFALSE,
                 portMAX_DELAY
             );
-
-            break;
-        case VFX_MODE_IDX_OFF:
-        default:
+        } else if (vfx.mode < VFX_MODE_IDX_MAX && vfx_effect[vfx.mode].render) {
+            vfx_run_effect(&vfx_effect[vfx.mode]);
+        } else {
             gdispGSetBacklight(vfx_gdisp, 0);
 
             vTaskDelay(500 / portTICK_RATE_MS);
 
+#ifdef CONFIG_SCREEN_PANEL_OUTPUT_VFX
             gdispGFillArea(vfx_gdisp, 0, 0, vfx_disp_width, vfx_disp_height, 0x000000);
+#else
+            vfx_voxel_clear();
+            vfx_voxel_present();
+#endif
+            gdispGFlush(vfx_gdisp);
 
             xEventGroupWaitBits(
                 user_event_group,
@@ -1967,8 +1431,6 @@ loop_break:
                 pdFALSE,
                 portMAX_DELAY
             );
-
-            break;
         }
     }
 }
@@ -1998,5 +1460,7 @@ void vfx_init(void)
 
     vfx_set_conf(&vfx);
 
+    vfx_spectrum_init();
+
     xTaskCreatePinnedToCore(vfx_task, "vfxT", 5120, NULL, 7, NULL, 1);
 }
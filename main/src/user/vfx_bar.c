@@ -0,0 +1,76 @@
+/*
+ * vfx_bar.c
+ *
+ *  Created on: 2026-10-17 20:10
+ *      Author: agent <agent@local>
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "user/vfx_bar.h"
+
+static const vfx_bar_config_t bar_conf_default = {
+    .attack = DEFAULT_VFX_BAR_ATTACK,
+    .release = DEFAULT_VFX_BAR_RELEASE,
+    .gravity = DEFAULT_VFX_BAR_GRAVITY,
+    .hold = DEFAULT_VFX_BAR_HOLD,
+};
+
+static vfx_bar_config_t bar_conf = {0};
+static uint16_t bar_num = 0;
+
+static float bar_level[VFX_BAR_CHANNELS][VFX_SPECTRUM_BANDS_MAX] = {0};
+static float bar_peak[VFX_BAR_CHANNELS][VFX_SPECTRUM_BANDS_MAX] = {0};
+static float bar_speed[VFX_BAR_CHANNELS][VFX_SPECTRUM_BANDS_MAX] = {0};
+static uint8_t bar_hold[VFX_BAR_CHANNELS][VFX_SPECTRUM_BANDS_MAX] = {0};
+
+void vfx_bar_set_conf(const vfx_bar_config_t *cfg)
+{
+    memcpy(&bar_conf, cfg, sizeof(vfx_bar_config_t));
+}
+
+void vfx_bar_reset(uint16_t num, const vfx_bar_config_t *cfg)
+{
+    vfx_bar_set_conf(cfg ? cfg : &bar_conf_default);
+
+    bar_num = num > VFX_SPECTRUM_BANDS_MAX ? VFX_SPECTRUM_BANDS_MAX : num;
+
+    memset(bar_level, 0x00, sizeof(bar_level));
+    memset(bar_peak, 0x00, sizeof(bar_peak));
+    memset(bar_speed, 0x00, sizeof(bar_speed));
+    memset(bar_hold, 0x00, sizeof(bar_hold));
+}
+
+void vfx_bar_update(uint8_t ch, const float *val, bool log_scale, float gain, int16_t min, int16_t max, int16_t *out, int16_t *peak)
+{
+    float *level = bar_level[ch];
+    float *top = bar_peak[ch];
+    float *speed = bar_speed[ch];
+    uint8_t *hold = bar_hold[ch];
+    const float gravity = bar_conf.gravity * (max - min);
+
+    for (uint16_t i=0; i<bar_num; i++) {
+        float v = log_scale ? 20.0f * log10f(val[i] + 1e-9f) : val[i];
+        float target = fminf(fmaxf(v * gain, min), max);
+        float coef = target > level[i] ? bar_conf.attack : bar_conf.release;
+
+        level[i] = fmaxf(level[i] + (target - level[i]) * coef, min);
+
+        if (level[i] >= top[i]) {
+            top[i] = level[i];
+            speed[i] = 0.0;
+            hold[i] = bar_conf.hold;
+        } else if (hold[i]) {
+            hold[i]--;
+        } else {
+            speed[i] += gravity;
+            top[i] = fmaxf(top[i] - speed[i], level[i]);
+        }
+
+        out[i] = lrintf(level[i]);
+        if (peak) {
+            peak[i] = lrintf(top[i]);
+        }
+    }
+}
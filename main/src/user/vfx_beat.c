@@ -0,0 +1,214 @@
+/*
+ * vfx_beat.c
+ *
+ *  Created on: 2026-10-17 19:05
+ *      Author: agent <agent@local>
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "user/vfx_beat.h"
+#include "user/vfx_spectrum.h"
+
+// onset envelope sample rate, the analysed windows are resampled to this grid
+#define ODF_RATE    (50)
+#define ODF_LEN     (64)    // power of 2, longer than LAG_MAX
+
+#define BPM_MIN     (60)
+#define BPM_MAX     (180)
+#define LAG_MIN     (ODF_RATE * 60 / BPM_MAX)
+#define LAG_MAX     (ODF_RATE * 60 / BPM_MIN)
+
+#define ACF_DECAY   (0.995f)    // about 4 s of envelope history
+#define THR_ALPHA   (0.05f)     // adaptive threshold time constant, in envelope samples
+#define THR_K       (1.5f)      // onset threshold above the mean, in mean deviations
+#define THR_MIN     (0.002f)    // keeps silence and noise from triggering onsets
+#define PLL_GAIN    (0.2f)      // phase correction applied on every onset
+#define TEMPO_ALPHA (0.1f)      // period smoothing
+
+static float flux_prev[VFX_SPECTRUM_BINS_MAX] = {0.0f};
+static uint16_t flux_bin_num = 0;
+
+static float odf[ODF_LEN] = {0.0f};
+static uint32_t odf_idx = 0;
+static float odf_acc = 0.0f;
+static uint32_t odf_time = 0;   // audio frames since the last envelope sample
+
+static float acf[LAG_MAX + 1] = {0.0f};   // acf[0] holds the decayed envelope energy
+static float acf_weight[LAG_MAX + 1] = {0.0f};
+
+static float thr_mean = 0.0f;
+static float thr_dev = 0.0f;
+
+static float beat_period = ODF_RATE / 2;    // in envelope samples, 120 BPM
+
+static vfx_beat_t beat = {0};
+
+static void vfx_beat_set_tempo(void)
+{
+    uint16_t best = LAG_MIN;
+
+    for (uint16_t lag=LAG_MIN+1; lag<=LAG_MAX; lag++) {
+        if (acf[lag] * acf_weight[lag] > acf[best] * acf_weight[best]) {
+            best = lag;
+        }
+    }
+
+    // no onsets for a while, the music has stopped
+    if (thr_mean < THR_MIN || acf[best] <= 0.0f) {
+        beat.confidence = 0.0f;
+        return;
+    }
+
+    // parabolic interpolation around the peak
+    float period = best;
+    if (best > LAG_MIN && best < LAG_MAX) {
+        float a = acf[best-1];
+        float b = acf[best];
+        float c = acf[best+1];
+        float d = a - 2 * b + c;
+
+        if (d < 0.0f) {
+            period += 0.5f * (a - c) / d;
+        }
+    }
+
+    beat_period += (period - beat_period) * TEMPO_ALPHA;
+
+    beat.bpm = 60.0f * ODF_RATE / beat_period;
+    beat.confidence = acf[best] < acf[0] ? acf[best] / acf[0] : 1.0f;
+}
+
+static void vfx_beat_push(float value)
+{
+    float prev1 = odf[(odf_idx - 1) & (ODF_LEN - 1)];
+    float prev2 = odf[(odf_idx - 2) & (ODF_LEN - 1)];
+
+    odf[odf_idx & (ODF_LEN - 1)] = value;
+
+    acf[0] = acf[0] * ACF_DECAY + value * value;
+    for (uint16_t lag=LAG_MIN; lag<=LAG_MAX; lag++) {
+        acf[lag] = acf[lag] * ACF_DECAY + value * odf[(odf_idx - lag) & (ODF_LEN - 1)];
+    }
+
+    odf_idx++;
+
+    beat.phase += 1.0f / beat_period;
+    if (beat.phase >= 1.0f) {
+        beat.phase -= 1.0f;
+        beat.beat_count++;
+    }
+
+    // the previous sample is an onset if it is a local maximum above the adaptive threshold
+    if (prev1 > prev2 && prev1 >= value && prev1 > thr_mean + THR_K * thr_dev + THR_MIN) {
+        float err = beat.phase - 1.0f / beat_period;
+
+        if (err >= 0.5f) {
+            err -= 1.0f;
+        } else if (err < -0.5f) {
+            err += 1.0f;
+        }
+
+        // pull the beat towards the onset, a late correction may complete the beat early
+        beat.phase -= err * PLL_GAIN;
+        if (beat.phase < 0.0f) {
+            beat.phase += 1.0f;
+        } else if (beat.phase >= 1.0f) {
+            beat.phase -= 1.0f;
+            beat.beat_count++;
+        }
+
+        beat.onset = true;
+    }
+
+    thr_mean += (value - thr_mean) * THR_ALPHA;
+    thr_dev += (fabsf(value - thr_mean) - thr_dev) * THR_ALPHA;
+
+    if ((odf_idx & 0x07) == 0) {
+        vfx_beat_set_tempo();
+    }
+}
+
+void vfx_beat_reset(void)
+{
+    memset(flux_prev, 0x00, sizeof(flux_prev));
+    flux_bin_num = 0;
+
+    memset(odf, 0x00, sizeof(odf));
+    odf_idx = 0;
+    odf_acc = 0.0f;
+    odf_time = 0;
+
+    memset(acf, 0x00, sizeof(acf));
+
+    thr_mean = 0.0f;
+    thr_dev = 0.0f;
+
+    beat_period = ODF_RATE / 2;
+
+    memset(&beat, 0x00, sizeof(vfx_beat_t));
+    beat.bpm = 60.0f * ODF_RATE / beat_period;
+}
+
+void vfx_beat_update(const float *amp, uint16_t bin_num, uint32_t frames, int rate)
+{
+    float flux = 0.0f;
+    uint32_t period = rate / ODF_RATE;
+
+    beat.onset = false;
+
+    // after a gap the envelope history no longer lines up, start over
+    if (frames > (uint32_t)rate || !period) {
+        vfx_beat_reset();
+        return;
+    }
+
+    for (uint16_t k=1; k<bin_num; k++) {
+        float level = log1pf(amp[k] / 256.0f);
+
+        if (level > flux_prev[k]) {
+            flux += level - flux_prev[k];
+        }
+
+        flux_prev[k] = level;
+    }
+
+    // the first window after a size change has nothing to compare with
+    if (bin_num != flux_bin_num) {
+        flux_bin_num = bin_num;
+        flux = 0.0f;
+    } else {
+        flux /= bin_num;
+    }
+
+    // several windows may land in one envelope sample, keep the strongest
+    if (flux > odf_acc) {
+        odf_acc = flux;
+    }
+
+    odf_time += frames;
+    while (odf_time >= period) {
+        odf_time -= period;
+
+        vfx_beat_push(odf_acc);
+        odf_acc = 0.0f;
+    }
+}
+
+const vfx_beat_t *vfx_beat_get(void)
+{
+    return &beat;
+}
+
+void vfx_beat_init(void)
+{
+    // favour periods around 120 BPM to settle octave errors
+    for (uint16_t lag=LAG_MIN; lag<=LAG_MAX; lag++) {
+        float octave = log2f(lag / (ODF_RATE / 2.0f));
+
+        acf_weight[lag] = expf(-0.5f * octave * octave / (0.9f * 0.9f));
+    }
+
+    vfx_beat_reset();
+}
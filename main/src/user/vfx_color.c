@@ -0,0 +1,51 @@
+/*
+ * vfx_color.c
+ *
+ *  Created on: 2026-10-17 22:40
+ *      Author: agent <agent@local>
+ */
+
+#include "esp_attr.h"
+
+#include "user/vfx_core.h"
+
+// fully saturated color of hue color_h (0-511), lightness color_l (0-511): 0 black, 255 pure hue, 511 white
+// returned in the gdisp pixel format, RGB565 on the panels and RGB888 on the cube
+uint32_t IRAM_ATTR vfx_get_color(uint16_t color_h, uint16_t color_l)
+{
+    uint16_t pos = (color_h & 0x01FF) * 6;
+    uint8_t rise = (pos & 0x01FF) >> 1;
+    uint8_t fall = 255 - rise;
+    uint8_t r = 0, g = 0, b = 0;
+
+    switch (pos >> 9) {
+        case 0: r = 255;  g = rise; b = 0;    break;
+        case 1: r = fall; g = 255;  b = 0;    break;
+        case 2: r = 0;    g = 255;  b = rise; break;
+        case 3: r = 0;    g = fall; b = 255;  break;
+        case 4: r = rise; g = 0;    b = 255;  break;
+        default: r = 255; g = 0;    b = fall; break;
+    }
+
+    if (color_l < 256) {
+        // darken towards black
+        uint16_t k = color_l + 1;
+
+        r = r * k >> 8;
+        g = g * k >> 8;
+        b = b * k >> 8;
+    } else {
+        // lighten towards white
+        uint16_t k = (color_l & 0x01FF) - 255;
+
+        r += (255 - r) * k >> 8;
+        g += (255 - g) * k >> 8;
+        b += (255 - b) * k >> 8;
+    }
+
+#ifdef CONFIG_VFX_OUTPUT_CUBE0414
+    return r << 16 | g << 8 | b;
+#else
+    return (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3;
+#endif
+}
@@ -15,109 +15,206 @@
 #include "user/vfx.h"
 #include "user/vfx_core.h"
 #include "user/vfx_bitmap.h"
-#include "user/vfx_color_table.h"
 
-inline uint32_t vfx_read_color_from_table(uint16_t color_h, uint16_t color_l)
+#ifdef CONFIG_SCREEN_PANEL_OUTPUT_VFX
+// gdisp color to the RGB565 word as it is stored in the panel framebuffer, high byte first
+uint16_t vfx_native_color(uint16_t color)
 {
-    uint16_t table_x = color_h;
-    uint16_t table_y = 511 - color_l;
+    return color << 8 | color >> 8;
+}
+
+// the back buffer the caller draws straight into, vfx_disp_width pixels per row, valid until the next flush
+uint16_t *vfx_get_framebuffer(void)
+{
+    void *fb = gdispGQuery(vfx_gdisp, GDISP_QUERY_FRAMEBUFFER);
+
+    return fb == (void *)-1 ? NULL : (uint16_t *)fb;
+}
 
-    uint8_t *pixel_addr = (uint8_t *)vfx_color_table_512 + (table_x + table_y * 512) * 3;
-    uint32_t pixel_color = *(pixel_addr + 0) << 16 | *(pixel_addr + 1) << 8 | *(pixel_addr + 2);
+// rows y to y + cy - 1 of the framebuffer were drawn into, they go out with the next flush
+void vfx_mark_dirty(int16_t y, int16_t cy)
+{
+    coord_t rows[2] = {y, cy};
 
-    return pixel_color;
+    gdispGControl(vfx_gdisp, GDISP_CONTROL_DIRTY_ROWS, rows);
 }
+#endif
 
 #ifndef CONFIG_SCREEN_PANEL_OUTPUT_VFX
-void vfx_draw_pixel(uint8_t x, uint8_t y, uint8_t z, uint16_t color_h, uint16_t color_l)
+vfx_voxel_t vfx_voxel = {0};
+
+#ifndef CONFIG_VFX_OUTPUT_CUBE0414
+// what the panel currently shows, only the voxels that differ get redrawn
+static vfx_voxel_t vfx_voxel_shown = {0};
+#endif
+
+void vfx_voxel_clear(void)
 {
-    uint32_t pixel_color = vfx_read_color_from_table(color_h, color_l);
-    uint8_t pixel_x = x + y * 8;
-    uint8_t pixel_y = z;
+    memset(vfx_voxel, 0x00, sizeof(vfx_voxel_t));
+}
 
-#ifdef CONFIG_VFX_OUTPUT_CUBE0414
-    gdispGDrawPixel(vfx_gdisp, pixel_x, pixel_y, pixel_color);
-#elif defined(CONFIG_VFX_OUTPUT_ST7735)
-    if (pixel_x <= 31) {
-        gdispGFillArea(vfx_gdisp, pixel_x * 5, pixel_y * 5, 5, 5, pixel_color);
-    } else {
-        gdispGFillArea(vfx_gdisp, (pixel_x - 32) * 5, (pixel_y + 8) * 5, 5, 5, pixel_color);
+void vfx_voxel_fill(uint8_t x, uint8_t y, uint8_t z, uint8_t cx, uint8_t cy, uint8_t cz, uint32_t color)
+{
+    if (x >= VFX_CUBE_N || y >= VFX_CUBE_N || z >= VFX_CUBE_N) {
+        return;
     }
-#else
-    if (pixel_x <= 31) {
-        gdispGFillArea(vfx_gdisp, pixel_x * 7 + 8, pixel_y * 7 + 12, 7, 7, pixel_color);
-    } else {
-        gdispGFillArea(vfx_gdisp, (pixel_x - 32) * 7 + 8, (pixel_y + 8) * 7 + 12, 7, 7, pixel_color);
+
+    cx = (x + cx > VFX_CUBE_N) ? VFX_CUBE_N - x : cx;
+    cy = (y + cy > VFX_CUBE_N) ? VFX_CUBE_N - y : cy;
+    cz = (z + cz > VFX_CUBE_N) ? VFX_CUBE_N - z : cz;
+
+    for (uint8_t k=z; k<z+cz; k++) {
+        for (uint8_t j=y; j<y+cy; j++) {
+            uint32_t *row = &vfx_voxel[k][j][x];
+
+            for (uint8_t i=0; i<cx; i++) {
+                row[i] = color;
+            }
+        }
     }
-#endif
 }
 
-void vfx_fill_cube(uint8_t x, uint8_t y, uint8_t z, uint8_t cx, uint8_t cy, uint8_t cz, uint16_t color_h, uint16_t color_l)
+void vfx_voxel_shift(vfx_axis_t axis, int8_t step)
 {
-    for (uint8_t i=0; i<cx; i++) {
-        for (uint8_t j=0; j<cy; j++) {
-            for (uint8_t k=0; k<cz; k++) {
-                vfx_draw_pixel(x+i, y+j, z+k, color_h, color_l);
+    static vfx_voxel_t tmp;
+
+    memcpy(tmp, vfx_voxel, sizeof(vfx_voxel_t));
+    vfx_voxel_clear();
+
+    for (int8_t z=0; z<VFX_CUBE_N; z++) {
+        for (int8_t y=0; y<VFX_CUBE_N; y++) {
+            for (int8_t x=0; x<VFX_CUBE_N; x++) {
+                int8_t sx = x - (axis == VFX_AXIS_X ? step : 0);
+                int8_t sy = y - (axis == VFX_AXIS_Y ? step : 0);
+                int8_t sz = z - (axis == VFX_AXIS_Z ? step : 0);
+
+                if (sx >= 0 && sx < VFX_CUBE_N && sy >= 0 && sy < VFX_CUBE_N && sz >= 0 && sz < VFX_CUBE_N) {
+                    vfx_voxel[z][y][x] = tmp[sz][sy][sx];
+                }
             }
         }
     }
 }
 
-void vfx_draw_cube_bitmap(const uint8_t *bitmap, uint16_t color_l)
+void vfx_voxel_copy_layer(vfx_axis_t axis, uint8_t src, uint8_t dst)
 {
-    uint8_t x = 0;
-    uint8_t y = 0;
-    uint8_t z = 0;
-    static uint16_t color_pre = 0;
-    static uint16_t color_h = 0;
+    for (uint8_t a=0; a<VFX_CUBE_N; a++) {
+        for (uint8_t b=0; b<VFX_CUBE_N; b++) {
+            switch (axis) {
+                case VFX_AXIS_X: vfx_voxel[a][b][dst] = vfx_voxel[a][b][src]; break;
+                case VFX_AXIS_Y: vfx_voxel[a][dst][b] = vfx_voxel[a][src][b]; break;
+                default:         vfx_voxel[dst][a][b] = vfx_voxel[src][a][b]; break;
+            }
+        }
+    }
+}
 
-    color_pre = color_h;
-    for (uint8_t i=0; i<64; i++) {
-        uint8_t temp = *(bitmap + i);
+// quarter turns counterclockwise around the vertical (z) axis
+void vfx_voxel_rotate(uint8_t turns)
+{
+    static uint32_t tmp[VFX_CUBE_N][VFX_CUBE_N];
 
-        for (uint8_t j=0; j<8; j++) {
-            if (temp & 0x80) {
-                vfx_draw_pixel(x, y, z, color_h, color_l);
-            } else {
-                vfx_draw_pixel(x, y, z, 0, 0);
+    turns %= 4;
+
+    for (uint8_t z=0; z<VFX_CUBE_N; z++) {
+        for (uint8_t n=0; n<turns; n++) {
+            memcpy(tmp, vfx_voxel[z], sizeof(tmp));
+
+            for (uint8_t y=0; y<VFX_CUBE_N; y++) {
+                for (uint8_t x=0; x<VFX_CUBE_N; x++) {
+                    vfx_voxel[z][y][x] = tmp[VFX_CUBE_N - 1 - x][y];
+                }
+            }
+        }
+    }
+}
+
+// one bitmap row per step along the lower of the other two axes, MSB first along the higher one,
+// bit n of the layer takes color[n * color_step] if set and is cleared otherwise
+void vfx_voxel_blit_layer(vfx_axis_t axis, uint8_t layer, const uint8_t *bitmap, const uint32_t *color, uint8_t color_step)
+{
+    if (layer >= VFX_CUBE_N) {
+        return;
+    }
+
+    for (uint8_t a=0; a<VFX_CUBE_N; a++) {
+        uint8_t temp = bitmap[a];
+
+        for (uint8_t b=0; b<VFX_CUBE_N; b++) {
+            uint32_t c = (temp & 0x80) ? color[(a * VFX_CUBE_N + b) * color_step] : 0x000000;
+
+            switch (axis) {
+                case VFX_AXIS_X: vfx_voxel[b][a][layer] = c; break;
+                case VFX_AXIS_Y: vfx_voxel[b][layer][a] = c; break;
+                default:         vfx_voxel[layer][b][a] = c; break;
             }
 
             temp <<= 1;
+        }
+    }
+}
 
-            if (z++ == 7) {
-                z = 0;
+void vfx_voxel_present(void)
+{
+#ifdef CONFIG_VFX_OUTPUT_CUBE0414
+    // [z][y][x] is already the 64x8 layout of the cube GRAM
+    gdispGBlitArea(vfx_gdisp, 0, 0, VFX_CUBE_N * VFX_CUBE_N, VFX_CUBE_N, 0, 0, VFX_CUBE_N * VFX_CUBE_N, (const pixel_t *)vfx_voxel);
+#else
+    for (uint8_t z=0; z<VFX_CUBE_N; z++) {
+        for (uint8_t y=0; y<VFX_CUBE_N; y++) {
+            for (uint8_t x=0; x<VFX_CUBE_N; x++) {
+                uint32_t pixel_color = vfx_voxel[z][y][x];
+                uint8_t pixel_x = x + y * 8;
+                uint8_t pixel_y = z;
 
-                if (x++ == 7) {
-                    x = 0;
-                    if (y++ == 7) {
-                        y = 0;
-                    }
+                if (pixel_color == vfx_voxel_shown[z][y][x]) {
+                    continue;
                 }
+                vfx_voxel_shown[z][y][x] = pixel_color;
 
-                if (color_h++ == 511) {
-                    color_h = 0;
+#ifdef CONFIG_VFX_OUTPUT_ST7735
+                if (pixel_x <= 31) {
+                    gdispGFillArea(vfx_gdisp, pixel_x * 5, pixel_y * 5, 5, 5, pixel_color);
+                } else {
+                    gdispGFillArea(vfx_gdisp, (pixel_x - 32) * 5, (pixel_y + 8) * 5, 5, 5, pixel_color);
                 }
+#else
+                if (pixel_x <= 31) {
+                    gdispGFillArea(vfx_gdisp, pixel_x * 7 + 8, pixel_y * 7 + 12, 7, 7, pixel_color);
+                } else {
+                    gdispGFillArea(vfx_gdisp, (pixel_x - 32) * 7 + 8, (pixel_y + 8) * 7 + 12, 7, 7, pixel_color);
+                }
+#endif
             }
         }
     }
+#endif
+}
 
-    if (color_pre == 510) {
-        color_h = 0;
-    } else {
-        color_h = color_pre + 2;
+void vfx_draw_pixel(uint8_t x, uint8_t y, uint8_t z, uint16_t color_h, uint16_t color_l)
+{
+    if (x >= VFX_CUBE_N || y >= VFX_CUBE_N || z >= VFX_CUBE_N) {
+        return;
     }
+
+    vfx_voxel[z][y][x] = vfx_get_color(color_h, color_l);
 }
 
-void vfx_draw_layer_bitmap(uint8_t layer, const uint8_t *bitmap, uint16_t color_l)
+void vfx_fill_cube(uint8_t x, uint8_t y, uint8_t z, uint8_t cx, uint8_t cy, uint8_t cz, uint16_t color_h, uint16_t color_l)
+{
+    vfx_voxel_fill(x, y, z, cx, cy, cz, vfx_get_color(color_h, color_l));
+}
+
+void vfx_draw_cube_bitmap(const uint8_t *bitmap, uint16_t color_l)
 {
     uint8_t x = 0;
     uint8_t y = 0;
-    uint8_t z = layer;
+    uint8_t z = 0;
     static uint16_t color_pre = 0;
     static uint16_t color_h = 0;
 
     color_pre = color_h;
-    for (uint8_t i=0; i<8; i++) {
+    for (uint8_t i=0; i<64; i++) {
         uint8_t temp = *(bitmap + i);
 
         for (uint8_t j=0; j<8; j++) {
@@ -129,51 +226,34 @@ void vfx_draw_layer_bitmap(uint8_t layer, const uint8_t *bitmap, uint16_t color_
 
             temp <<= 1;
 
-            if (y++ == 7) {
-                y = 0;
+            if (z++ == 7) {
+                z = 0;
+
                 if (x++ == 7) {
                     x = 0;
+                    if (y++ == 7) {
+                        y = 0;
+                    }
                 }
-            }
 
-            if (color_h++ == 511) {
-                color_h = 0;
+                if (color_h++ == 511) {
+                    color_h = 0;
+                }
             }
         }
     }
 
-    if (color_pre == 511) {
+    if (color_pre == 510) {
         color_h = 0;
     } else {
-        color_h = color_pre + 1;
+        color_h = color_pre + 2;
     }
 }
 
 void vfx_draw_layer_number(uint8_t num, uint8_t layer, uint16_t color_h, uint16_t color_l)
 {
-    uint8_t x = 0;
-    uint8_t y = layer;
-    uint8_t z = 0;
+    uint32_t color = vfx_get_color(color_h, color_l);
 
-    for (uint8_t i=0; i<8; i++) {
-        unsigned char temp = vfx_bitmap_number[num][i];
-
-        for (uint8_t j=0; j<8; j++) {
-            if (temp & 0x80) {
-                vfx_draw_pixel(x, y, z, color_h, color_l);
-            } else {
-                vfx_draw_pixel(x, y, z, 0, 0);
-            }
-
-            temp <<= 1;
-
-            if (z++ == 7) {
-                z = 0;
-                if (x++ == 7) {
-                    x = 7;
-                }
-            }
-        }
-    }
+    vfx_voxel_blit_layer(VFX_AXIS_Y, layer, vfx_bitmap_number[num], &color, 0);
 }
 #endif // CONFIG_SCREEN_PANEL_OUTPUT_VFX
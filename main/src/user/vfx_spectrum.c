@@ -0,0 +1,712 @@
+/*
+ * vfx_spectrum.c
+ *
+ *  Created on: 2026-10-17 16:20
+ *      Author: agent <agent@local>
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include "fft.h"
+
+#include "core/os.h"
+#include "core/app.h"
+#include "user/vfx_bar.h"
+#include "user/vfx_beat.h"
+#include "user/vfx_spectrum.h"
+
+#ifdef CONFIG_VFX_SPECTRUM_BENCHMARK
+#include "xtensa/hal.h"
+#endif
+
+#define TAG "vfx_spectrum"
+
+// producer sample history, holds the largest window plus one hop
+#define RING_FRAMES (2 * VFX_SPECTRUM_SIZE_MAX)
+
+// triple buffer slot index in bits 0-1, set when the middle slot holds an unread window
+#define TB_FRESH    (0x04)
+#define TB_IDX_MASK (0x03)
+
+// frequency range of the log, mel and octave band maps
+#define BAND_FREQ_MIN (40.0)
+#define BAND_FREQ_MAX (16000.0)
+
+static vfx_spectrum_config_t spec_conf = {
+    .size = DEFAULT_VFX_SPECTRUM_SIZE,
+    .window = DEFAULT_VFX_SPECTRUM_WINDOW,
+    .scale = DEFAULT_VFX_SPECTRUM_SCALE,
+};
+static volatile bool spec_conf_pending = true;
+
+typedef struct {
+    int16_t frame[VFX_SPECTRUM_SIZE_MAX][2];
+    uint32_t seq;
+    uint16_t size;
+    vfx_spectrum_channel_t channel;
+} vfx_spectrum_window_buf_t;
+
+// owned by the audio producer, only one of them runs at a time
+static int16_t  ring[RING_FRAMES][2] = {0};
+static uint32_t ring_wr = 0;    // frames written since boot
+static uint32_t ring_fill = 0;  // frames written since the last published window
+
+/*
+ * Triple buffer between the audio producer and the vfx task: the producer
+ * fills tb_back, the consumer reads tb_front, and both swap their slot with
+ * tb_middle atomically, so neither side blocks and no window is torn.
+ */
+static vfx_spectrum_window_buf_t tb_buf[3] = {0};
+static uint8_t tb_back = 0;
+static uint32_t tb_middle = 1;
+static uint8_t tb_front = 2;
+
+static uint32_t tb_size = DEFAULT_VFX_SPECTRUM_SIZE;    // window size requested by the consumer
+static uint32_t tb_seq = 0;
+static vfx_spectrum_stats_t tb_stats = {0};
+
+/*
+ * The ring, tb_back and tb_seq belong to whoever holds tb_owner. A clear from
+ * another task only posts tb_clear, it is run by the clearing task when the
+ * producer is idle, otherwise by the producer right after its write.
+ */
+static uint8_t tb_owner = 0;
+static uint8_t tb_clear = 0;
+
+static volatile int spec_sample_rate = 44100;
+static int spec_map_rate = 0;
+
+static uint16_t spec_size = 0;
+static int16_t  spec_frame[VFX_SPECTRUM_SIZE_MAX] = {0};
+static int16_t  spec_window[VFX_SPECTRUM_SIZE_MAX] = {0};   // Q15
+static float    spec_scale = 0.0;   // window coherent gain compensation and one-sided scaling
+
+#if defined(CONFIG_VFX_SPECTRUM_FIXED_POINT) || defined(CONFIG_VFX_SPECTRUM_BENCHMARK)
+static fft_config_t *spec_fft_q15 = NULL;
+
+static int16_t spec_input_q15[VFX_SPECTRUM_SIZE_MAX] = {0};
+static int32_t spec_output_q15[VFX_SPECTRUM_SIZE_MAX] = {0};
+#endif
+
+#if !defined(CONFIG_VFX_SPECTRUM_FIXED_POINT) || defined(CONFIG_VFX_SPECTRUM_BENCHMARK)
+static fft_config_t *spec_fft = NULL;
+
+static float spec_input[VFX_SPECTRUM_SIZE_MAX] = {0.0};
+static float spec_output[VFX_SPECTRUM_SIZE_MAX] = {0.0};
+#endif
+
+// one complex fft of L + jR gives both channel spectra, allocated while a stereo mode runs
+static bool spec_stereo = false;
+static fft_config_t *spec_fft_stereo = NULL;
+
+// band k covers the bins from spec_band_edge[k] to spec_band_edge[k+1] - 1
+static uint16_t spec_band_edge[VFX_SPECTRUM_BANDS_MAX + 1] = {0};
+
+static vfx_spectrum_t spec = {0};
+
+#if defined(CONFIG_VFX_SPECTRUM_FIXED_POINT) || defined(CONFIG_VFX_SPECTRUM_BENCHMARK)
+static void vfx_spectrum_analyse_q15(float *amp)
+{
+    for (uint16_t k=0; k<spec_size; k++) {
+        spec_input_q15[k] = (spec_frame[k] * spec_window[k] + (1 << 14)) >> 15;
+    }
+
+    fft_execute(spec_fft_q15);
+
+    float scale = ldexpf(spec_scale, spec_fft_q15->exponent);
+
+    amp[0] = abs(spec_output_q15[0]) * scale / 2;
+    for (uint16_t k=1; k<spec_size/2; k++) {
+        amp[k] = fft_magnitude_q15(spec_output_q15[2*k], spec_output_q15[2*k+1]) * scale;
+    }
+}
+#endif
+
+#if !defined(CONFIG_VFX_SPECTRUM_FIXED_POINT) || defined(CONFIG_VFX_SPECTRUM_BENCHMARK)
+static void vfx_spectrum_analyse_float(float *amp)
+{
+    for (uint16_t k=0; k<spec_size; k++) {
+        spec_input[k] = spec_frame[k] * spec_window[k] / 32768.0;
+    }
+
+    fft_execute(spec_fft);
+
+    // spec_output[0] is the DC term and spec_output[1] the Nyquist term
+    amp[0] = fabsf(spec_output[0]) * spec_scale / 2;
+    for (uint16_t k=1; k<spec_size/2; k++) {
+        float re = spec_output[2*k];
+        float im = spec_output[2*k+1];
+
+        amp[k] = sqrtf(re * re + im * im) * spec_scale;
+    }
+}
+#endif
+
+static void vfx_spectrum_analyse_stereo(const int16_t (*frame)[2], float *amp_l, float *amp_r)
+{
+    float *in = spec_fft_stereo->input;
+    float *out = spec_fft_stereo->output;
+
+    for (uint16_t k=0; k<spec_size; k++) {
+        in[2*k]   = frame[k][0] * spec_window[k] / 32768.0;
+        in[2*k+1] = frame[k][1] * spec_window[k] / 32768.0;
+    }
+
+    fft_execute(spec_fft_stereo);
+
+    // Z[k] = L[k] + jR[k], L[k] = (Z[k] + Z*[N-k]) / 2, R[k] = (Z[k] - Z*[N-k]) / 2j
+    amp_l[0] = fabsf(out[0]) * spec_scale / 2;
+    amp_r[0] = fabsf(out[1]) * spec_scale / 2;
+    for (uint16_t k=1; k<spec_size/2; k++) {
+        float zr = out[2*k];
+        float zi = out[2*k+1];
+        float cr = out[2*(spec_size-k)];
+        float ci = out[2*(spec_size-k)+1];
+
+        amp_l[k] = sqrtf((zr + cr) * (zr + cr) + (zi - ci) * (zi - ci)) * spec_scale / 2;
+        amp_r[k] = sqrtf((zr - cr) * (zr - cr) + (zi + ci) * (zi + ci)) * spec_scale / 2;
+    }
+}
+
+static void vfx_spectrum_init_stereo(void)
+{
+    if (spec_fft_stereo) {
+        if (spec_fft_stereo->size == spec_size) {
+            return;
+        }
+        fft_destroy(spec_fft_stereo);
+    }
+
+    spec_fft_stereo = fft_init(spec_size, FFT_COMPLEX, FFT_FORWARD, NULL, NULL);
+    if (!spec_fft_stereo) {
+        ESP_LOGE(TAG, "failed to allocate stereo fft config");
+    }
+}
+
+#ifdef CONFIG_VFX_SPECTRUM_BENCHMARK
+#define BENCH_WINDOWS (256)
+
+static uint32_t bench_windows = 0;
+static uint32_t bench_q15     = 0;
+static uint32_t bench_float   = 0;
+static float    bench_error   = 0.0;
+
+static void vfx_spectrum_bench(void)
+{
+    static float amp_q15[VFX_SPECTRUM_BINS_MAX] = {0.0};
+    static float amp_float[VFX_SPECTRUM_BINS_MAX] = {0.0};
+    float peak = 0.0, error = 0.0;
+
+    uint32_t start = xthal_get_ccount();
+    vfx_spectrum_analyse_q15(amp_q15);
+    bench_q15 += xthal_get_ccount() - start;
+
+    start = xthal_get_ccount();
+    vfx_spectrum_analyse_float(amp_float);
+    bench_float += xthal_get_ccount() - start;
+
+    for (uint16_t k=0; k<spec_size/2; k++) {
+        if (amp_float[k] > peak) {
+            peak = amp_float[k];
+        }
+        if (fabsf(amp_q15[k] - amp_float[k]) > error) {
+            error = fabsf(amp_q15[k] - amp_float[k]);
+        }
+    }
+
+    // worst bin error relative to the strongest bin
+    if (peak > 1.0 && error / peak > bench_error) {
+        bench_error = error / peak;
+    }
+
+    if (++bench_windows == BENCH_WINDOWS) {
+        ESP_LOGI(TAG, "size: %u, fixed: %u cycles, float: %u cycles, max error: %.1f dB", spec_size,
+                 bench_q15 / BENCH_WINDOWS, bench_float / BENCH_WINDOWS,
+                 20 * log10f(bench_error + 1e-9));
+
+        bench_windows = 0;
+        bench_q15     = 0;
+        bench_float   = 0;
+        bench_error   = 0.0;
+    }
+}
+#endif
+
+static float vfx_spectrum_band_freq(uint8_t scale, uint16_t k, uint16_t band_num)
+{
+    float t = (float)k / band_num;
+
+    switch (scale) {
+    case VFX_SPECTRUM_SCALE_MEL: {
+        float mel_lo = 2595 * log10f(1 + BAND_FREQ_MIN / 700);
+        float mel_hi = 2595 * log10f(1 + BAND_FREQ_MAX / 700);
+
+        return 700 * (powf(10, (mel_lo + (mel_hi - mel_lo) * t) / 2595) - 1);
+    }
+    case VFX_SPECTRUM_SCALE_OCTAVE: {
+        // whole fractional-octave bands on the 1 kHz grid that cover the range
+        float octaves = log2f(BAND_FREQ_MAX / BAND_FREQ_MIN);
+        float frac = ceilf(band_num / octaves);
+        float first = floorf(frac * log2f(BAND_FREQ_MIN / 1000));
+
+        return 1000 * exp2f((first + k) / frac);
+    }
+    case VFX_SPECTRUM_SCALE_LOG:
+    default:
+        return BAND_FREQ_MIN * powf(BAND_FREQ_MAX / BAND_FREQ_MIN, t);
+    }
+}
+
+static void vfx_spectrum_set_band_map(uint16_t band_num)
+{
+    uint16_t bin_num = spec_size / 2;
+
+    if (band_num > VFX_SPECTRUM_BANDS_MAX) {
+        band_num = VFX_SPECTRUM_BANDS_MAX;
+    } else if (band_num < 1) {
+        band_num = 1;
+    }
+
+    if (spec_conf.scale == VFX_SPECTRUM_SCALE_LINEAR) {
+        for (uint16_t k=0; k<=band_num; k++) {
+            spec_band_edge[k] = k * bin_num / band_num;
+        }
+    } else {
+        float bin_hz = (float)spec_map_rate / spec_size;
+
+        for (uint16_t k=0; k<=band_num; k++) {
+            int32_t bin = lrintf(vfx_spectrum_band_freq(spec_conf.scale, k, band_num) / bin_hz);
+
+            spec_band_edge[k] = bin < 1 ? 1 : (bin > bin_num ? bin_num : bin);
+        }
+    }
+
+    // every band takes at least one bin, bass bands narrower than a bin move up
+    for (uint16_t k=0; k<band_num; k++) {
+        if (spec_band_edge[k+1] <= spec_band_edge[k]) {
+            spec_band_edge[k+1] = spec_band_edge[k] + 1;
+        }
+    }
+    if (spec_band_edge[band_num] > bin_num) {
+        spec_band_edge[band_num] = bin_num;
+        for (int16_t k=band_num-1; k>=0; k--) {
+            if (spec_band_edge[k] >= spec_band_edge[k+1]) {
+                spec_band_edge[k] = spec_band_edge[k+1] - 1;
+            }
+        }
+    }
+
+    spec.bin_num = bin_num;
+    spec.band_num = band_num;
+}
+
+static void vfx_spectrum_set_band_amp(const float *amp, float *band_amp)
+{
+    for (uint16_t i=0; i<spec.band_num; i++) {
+        float peak = 0.0;
+
+        for (uint16_t k=spec_band_edge[i]; k<spec_band_edge[i+1]; k++) {
+            if (amp[k] > peak) {
+                peak = amp[k];
+            }
+        }
+
+        band_amp[i] = peak;
+    }
+}
+
+static void vfx_spectrum_apply_conf(void)
+{
+    if (spec_conf.size != spec_size) {
+        spec_size = spec_conf.size;
+        __atomic_store_n(&tb_size, spec_size, __ATOMIC_RELAXED);
+
+#if defined(CONFIG_VFX_SPECTRUM_FIXED_POINT) || defined(CONFIG_VFX_SPECTRUM_BENCHMARK)
+        if (spec_fft_q15) {
+            fft_destroy(spec_fft_q15);
+        }
+        spec_fft_q15 = fft_init_q15(spec_size, FFT_REAL, FFT_FORWARD, spec_input_q15, spec_output_q15);
+        if (!spec_fft_q15) {
+            ESP_LOGE(TAG, "failed to allocate fft config");
+        }
+#endif
+
+#if !defined(CONFIG_VFX_SPECTRUM_FIXED_POINT) || defined(CONFIG_VFX_SPECTRUM_BENCHMARK)
+        if (spec_fft) {
+            fft_destroy(spec_fft);
+        }
+        spec_fft = fft_init(spec_size, FFT_REAL, FFT_FORWARD, spec_input, spec_output);
+        if (!spec_fft) {
+            ESP_LOGE(TAG, "failed to allocate fft config");
+        }
+#endif
+    }
+
+    if (spec_stereo) {
+        vfx_spectrum_init_stereo();
+    }
+
+    float sum = 0.0;
+    for (uint16_t k=0; k<spec_size; k++) {
+        float x = 2 * M_PI * k / spec_size;
+        float w = 0.0;
+
+        if (spec_conf.window == VFX_SPECTRUM_WINDOW_BLACKMAN) {
+            w = 0.42 - 0.5 * cosf(x) + 0.08 * cosf(2 * x);
+        } else {
+            w = 0.5 - 0.5 * cosf(x);
+        }
+
+        spec_window[k] = lrintf(w * 32767);
+        sum += spec_window[k] / 32768.0;
+    }
+
+    // a full scale sine reads its amplitude whatever the window and size
+    spec_scale = 2 / sum;
+
+    spec_map_rate = spec_sample_rate;
+    vfx_spectrum_set_band_map(spec.band_num);
+
+    memset(spec.amp, 0x00, sizeof(spec.amp));
+    memset(spec.amp_r, 0x00, sizeof(spec.amp_r));
+
+    ESP_LOGI(TAG, "size: %u, window: %u, scale: %u, rate: %d", spec_size, spec_conf.window, spec_conf.scale, spec_map_rate);
+}
+
+static void vfx_spectrum_publish(uint16_t size, vfx_spectrum_channel_t channel)
+{
+    vfx_spectrum_window_buf_t *buf = &tb_buf[tb_back];
+
+    // the window ends at the last hop boundary, the frames after it belong to the next one
+    uint32_t pos = ring_wr - ring_fill - size;
+    for (uint16_t k=0; k<size; k++, pos++) {
+        int16_t *frame = ring[pos & (RING_FRAMES - 1)];
+
+        buf->frame[k][0] = frame[0];
+        buf->frame[k][1] = frame[1];
+    }
+
+    buf->seq = ++tb_seq;
+    buf->size = size;
+    buf->channel = channel;
+
+    uint32_t prev = __atomic_exchange_n(&tb_middle, tb_back | TB_FRESH, __ATOMIC_ACQ_REL);
+    if (prev & TB_FRESH) {
+        __atomic_add_fetch(&tb_stats.dropped, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&tb_stats.published, 1, __ATOMIC_RELAXED);
+
+    tb_back = prev & TB_IDX_MASK;
+}
+
+static bool vfx_spectrum_claim(void)
+{
+    uint8_t idle = 0;
+
+    return __atomic_compare_exchange_n(&tb_owner, &idle, 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static void vfx_spectrum_release(void)
+{
+    __atomic_store_n(&tb_owner, 0, __ATOMIC_SEQ_CST);
+}
+
+static void vfx_spectrum_reset(void)
+{
+    uint16_t size = __atomic_load_n(&tb_size, __ATOMIC_RELAXED);
+
+    memset(ring, 0x00, sizeof(ring));
+
+    // one window of silence brings the bars down
+    ring_wr += size;
+    ring_fill = 0;
+
+    vfx_spectrum_publish(size, VFX_SPECTRUM_CHANNEL_BOTH);
+}
+
+/* runs a posted clear unless the other side holds the producer state, which then runs it on release */
+static void vfx_spectrum_run_clear(void)
+{
+    while (__atomic_load_n(&tb_clear, __ATOMIC_SEQ_CST) && vfx_spectrum_claim()) {
+        if (__atomic_exchange_n(&tb_clear, 0, __ATOMIC_SEQ_CST)) {
+            vfx_spectrum_reset();
+        }
+        vfx_spectrum_release();
+    }
+}
+
+static void vfx_spectrum_write_locked(const uint8_t *data, uint32_t len, vfx_spectrum_channel_t channel)
+{
+    const int16_t *frame = (const int16_t *)data;
+    uint32_t n = len / 4;
+    uint16_t size = __atomic_load_n(&tb_size, __ATOMIC_RELAXED);
+    uint16_t hop = size / 2;
+
+    if (n > RING_FRAMES) {
+        frame += (n - RING_FRAMES) * 2;
+        n = RING_FRAMES;
+    }
+
+    for (uint32_t i=0; i<n; i++) {
+        uint32_t idx = (ring_wr + i) & (RING_FRAMES - 1);
+
+        ring[idx][0] = frame[2*i];
+        ring[idx][1] = frame[2*i+1];
+    }
+
+    ring_wr += n;
+    ring_fill += n;
+
+    if (ring_fill < hop) {
+        return;
+    }
+
+    // only the latest complete window is published, the skipped hops count as dropped
+    uint32_t skipped = ring_fill / hop - 1;
+    if (skipped) {
+        __atomic_add_fetch(&tb_stats.dropped, skipped, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&tb_stats.published, skipped, __ATOMIC_RELAXED);
+        tb_seq += skipped;
+    }
+    ring_fill %= hop;
+
+    vfx_spectrum_publish(size, channel);
+}
+
+void vfx_spectrum_write(const uint8_t *data, uint32_t len, vfx_spectrum_channel_t channel)
+{
+    // a clear in progress owns the ring, this block is only lost to the display
+    if (vfx_spectrum_claim()) {
+        if (__atomic_exchange_n(&tb_clear, 0, __ATOMIC_SEQ_CST)) {
+            vfx_spectrum_reset();
+        }
+        vfx_spectrum_write_locked(data, len, channel);
+        vfx_spectrum_release();
+    }
+
+    vfx_spectrum_run_clear();
+}
+
+void vfx_spectrum_clear(void)
+{
+    __atomic_store_n(&tb_clear, 1, __ATOMIC_SEQ_CST);
+
+    vfx_spectrum_run_clear();
+}
+
+void vfx_spectrum_get_stats(vfx_spectrum_stats_t *stats)
+{
+    stats->published = __atomic_load_n(&tb_stats.published, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&tb_stats.dropped, __ATOMIC_RELAXED);
+}
+
+void vfx_spectrum_set_sample_rate(int rate)
+{
+    spec_sample_rate = rate;
+}
+
+void vfx_spectrum_set_conf(vfx_spectrum_config_t *cfg)
+{
+    if (cfg->size != 256 && cfg->size != 512 && cfg->size != 1024) {
+        cfg->size = DEFAULT_VFX_SPECTRUM_SIZE;
+    }
+    if (cfg->window >= VFX_SPECTRUM_WINDOW_MAX) {
+        cfg->window = DEFAULT_VFX_SPECTRUM_WINDOW;
+    }
+    if (cfg->scale >= VFX_SPECTRUM_SCALE_MAX) {
+        cfg->scale = DEFAULT_VFX_SPECTRUM_SCALE;
+    }
+
+    if (cfg != &spec_conf) {
+        memcpy(&spec_conf, cfg, sizeof(vfx_spectrum_config_t));
+    }
+
+    // applied by the vfx task before its next analysis
+    spec_conf_pending = true;
+
+    ESP_LOGI(TAG, "size: %u, window: %u, scale: %u", spec_conf.size, spec_conf.window, spec_conf.scale);
+}
+
+vfx_spectrum_config_t *vfx_spectrum_get_conf(void)
+{
+    return &spec_conf;
+}
+
+static void vfx_spectrum_start_mode(uint16_t band_num, bool stereo)
+{
+    spec_stereo = stereo;
+    spec.stereo = stereo;
+
+    if (spec_conf_pending) {
+        spec_conf_pending = false;
+        spec.band_num = band_num;
+        vfx_spectrum_apply_conf();
+    } else {
+        vfx_spectrum_set_band_map(band_num);
+    }
+
+    if (stereo) {
+        vfx_spectrum_init_stereo();
+    }
+
+    vfx_beat_reset();
+    vfx_bar_reset(spec.band_num, NULL);
+
+    memset(spec.amp, 0x00, sizeof(spec.amp));
+    memset(spec.amp_r, 0x00, sizeof(spec.amp_r));
+    memset(spec.band_amp, 0x00, sizeof(spec.band_amp));
+    memset(spec.band_amp_r, 0x00, sizeof(spec.band_amp_r));
+
+    // discard the window left over from the previous mode
+    if (__atomic_load_n(&tb_middle, __ATOMIC_RELAXED) & TB_FRESH) {
+        tb_front = __atomic_exchange_n(&tb_middle, tb_front, __ATOMIC_ACQ_REL) & TB_IDX_MASK;
+    }
+
+    xEventGroupSetBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+}
+
+void vfx_spectrum_start(uint16_t band_num)
+{
+    vfx_spectrum_start_mode(band_num, false);
+}
+
+void vfx_spectrum_start_stereo(uint16_t band_num)
+{
+    vfx_spectrum_start_mode(band_num, true);
+}
+
+void vfx_spectrum_stop(void)
+{
+    vfx_spectrum_stats_t stats = {0};
+    vfx_spectrum_get_stats(&stats);
+
+    ESP_LOGI(TAG, "published: %u, dropped: %u", stats.published, stats.dropped);
+
+    xEventGroupClearBits(user_event_group, AUDIO_INPUT_FFT_BIT);
+
+    if (spec_fft_stereo) {
+        fft_destroy(spec_fft_stereo);
+        spec_fft_stereo = NULL;
+    }
+    spec_stereo = false;
+}
+
+bool vfx_spectrum_update(void)
+{
+    if (spec_conf_pending || spec_map_rate != spec_sample_rate) {
+        spec_conf_pending = false;
+        vfx_spectrum_apply_conf();
+    }
+
+    if (!(__atomic_load_n(&tb_middle, __ATOMIC_RELAXED) & TB_FRESH)) {
+        return false;
+    }
+
+    tb_front = __atomic_exchange_n(&tb_middle, tb_front, __ATOMIC_ACQ_REL) & TB_IDX_MASK;
+
+    const vfx_spectrum_window_buf_t *buf = &tb_buf[tb_front];
+
+    // published before the last size change
+    if (buf->size != spec_size) {
+        return false;
+    }
+
+    // audio frames since the previous analysed window, dropped windows included
+    uint32_t frames = (buf->seq - spec.seq) * (spec_size / 2);
+
+    if (spec_stereo) {
+        if (spec_fft_stereo) {
+            vfx_spectrum_analyse_stereo(buf->frame, spec.amp, spec.amp_r);
+        }
+
+        spec.seq = buf->seq;
+
+        vfx_beat_update(spec.amp, spec_size / 2, frames, spec_map_rate);
+
+        vfx_spectrum_set_band_amp(spec.amp, spec.band_amp);
+        vfx_spectrum_set_band_amp(spec.amp_r, spec.band_amp_r);
+
+        return true;
+    }
+
+    for (uint16_t k=0; k<spec_size; k++) {
+        if (buf->channel == VFX_SPECTRUM_CHANNEL_LEFT) {
+            spec_frame[k] = buf->frame[k][0];
+        } else if (buf->channel == VFX_SPECTRUM_CHANNEL_RIGHT) {
+            spec_frame[k] = buf->frame[k][1];
+        } else {
+            spec_frame[k] = (buf->frame[k][0] + buf->frame[k][1]) / 2;
+        }
+    }
+
+#ifdef CONFIG_VFX_SPECTRUM_BENCHMARK
+    vfx_spectrum_bench();
+#endif
+
+#ifdef CONFIG_VFX_SPECTRUM_FIXED_POINT
+    if (spec_fft_q15) {
+        vfx_spectrum_analyse_q15(spec.amp);
+    }
+#else
+    if (spec_fft) {
+        vfx_spectrum_analyse_float(spec.amp);
+    }
+#endif
+
+    spec.seq = buf->seq;
+
+    vfx_beat_update(spec.amp, spec_size / 2, frames, spec_map_rate);
+
+    vfx_spectrum_set_band_amp(spec.amp, spec.band_amp);
+
+    return true;
+}
+
+const vfx_spectrum_t *vfx_spectrum_get(void)
+{
+    return &spec;
+}
+
+static float vfx_spectrum_get_gain(uint16_t height, uint16_t scale_factor)
+{
+    return (float)scale_factor / (65536 / height);
+}
+
+void vfx_spectrum_get_height(int16_t *out, int16_t *peak, bool log_scale, uint16_t height, uint16_t scale_factor, int16_t min, int16_t max)
+{
+    const float gain = vfx_spectrum_get_gain(height, scale_factor);
+
+    vfx_bar_update(0, spec.band_amp, log_scale, gain, min, max, out, peak);
+}
+
+void vfx_spectrum_get_stereo_height(int16_t *out_l, int16_t *out_r, bool log_scale, uint16_t height, uint16_t scale_factor, int16_t min, int16_t max)
+{
+    const float gain = vfx_spectrum_get_gain(height, scale_factor);
+
+    vfx_bar_update(0, spec.band_amp, log_scale, gain, min, max, out_l, NULL);
+    vfx_bar_update(1, spec.band_amp_r, log_scale, gain, min, max, out_r, NULL);
+}
+
+void vfx_spectrum_init(void)
+{
+    size_t length = sizeof(vfx_spectrum_config_t);
+    app_getenv("FFT_INIT_CFG", &spec_conf, &length);
+
+    vfx_spectrum_set_conf(&spec_conf);
+
+    spec.band_num = VFX_SPECTRUM_BANDS_MAX;
+
+    vfx_beat_init();
+
+#ifdef CONFIG_VFX_SPECTRUM_FIXED_POINT
+    ESP_LOGI(TAG, "initialized, fixed-point");
+#else
+    ESP_LOGI(TAG, "initialized, floating-point");
+#endif
+}
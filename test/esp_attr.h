@@ -0,0 +1,17 @@
+/*
+ * esp_attr.h
+ *
+ *  Created on: 2026-10-17 22:40
+ *      Author: agent <agent@local>
+ */
+
+/* host stand-in for the ESP-IDF section attributes */
+
+#ifndef TEST_ESP_ATTR_H_
+#define TEST_ESP_ATTR_H_
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+
+#endif /* TEST_ESP_ATTR_H_ */
@@ -0,0 +1,20 @@
+/*
+ * esp_log.h
+ *
+ *  Created on: 2026-10-17 21:40
+ *      Author: agent <agent@local>
+ */
+
+/* host stand-in for the ESP-IDF logging macros */
+
+#ifndef TEST_ESP_LOG_H_
+#define TEST_ESP_LOG_H_
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, fmt, ...) printf("E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) printf("W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) printf("I %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do {} while (0)
+
+#endif /* TEST_ESP_LOG_H_ */
@@ -0,0 +1,157 @@
+/*
+ * test_audio_drift.c
+ *
+ *  Created on: 2026-10-17 21:20
+ *      Author: agent <agent@local>
+ */
+
+/*
+ * Host simulation of the output ring: the A2DP source delivers 20 ms packets
+ * from its own clock with arrival jitter and occasional stalls, the I2S writer
+ * drains 128-frame chunks at the local clock and resamples by the controller
+ * estimate. The controller has to find the clock offset without ever letting
+ * the ring run dry or overflow once playback has started.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "user/audio_drift.h"
+
+#define RATE            (44100)
+#define RING_FRAMES     (16384 / 4)
+#define TARGET_FRAMES   (RATE * 40 / 1000)
+#define PACKET_FRAMES   (RATE * 20 / 1000)
+#define CHUNK_FRAMES    (128)
+
+#define JITTER_MS       (20.0)
+#define STALL_EVERY_S   (20.0)
+#define STALL_MS        (10.0)
+
+#define SIM_SECONDS     (10 * 60)
+#define SETTLE_SECONDS  (2 * 60)
+
+#define PPM_TOLERANCE   (20.0)
+#define FILL_TOLERANCE  (0.10)
+
+static uint32_t rnd_state = 1;
+
+static double rnd(void)
+{
+    rnd_state = rnd_state * 1664525u + 1013904223u;
+    return (rnd_state >> 8) / 16777216.0;
+}
+
+static int run(double src_ppm)
+{
+    audio_drift_t drift;
+    audio_drift_reset(&drift, TARGET_FRAMES > RING_FRAMES / 2 ? RING_FRAMES / 2 : TARGET_FRAMES);
+
+    double src_period = PACKET_FRAMES / (RATE * (1.0 + src_ppm * 1e-6));
+    double src_next   = 0.0;        // source clock time of the next packet
+    double arrive     = 0.0;        // arrival time of the previous packet
+    double next_stall = STALL_EVERY_S;
+
+    double fill = 0.0;
+    int started = 0;
+    unsigned underruns = 0, overruns = 0;
+
+    double ppm_min = 1e9, ppm_max = -1e9;
+    double fill_min = 1e9, fill_max = -1e9;
+    double ppm_sum = 0.0, fill_sum = 0.0;
+    unsigned settled = 0;
+
+    double t = 0.0;
+    double chunk_period = (double)CHUNK_FRAMES / RATE;
+
+    while (t < SIM_SECONDS) {
+        t += chunk_period;
+
+        // deliver every packet that has arrived by now, in order
+        for (;;) {
+            double jitter = rnd() * JITTER_MS / 1000.0;
+            double at = src_next + jitter;
+            if (src_next >= next_stall) {
+                at += STALL_MS / 1000.0;
+            }
+            if (at < arrive) {
+                at = arrive;
+            }
+            if (at > t) {
+                break;
+            }
+            if (src_next >= next_stall) {
+                next_stall += STALL_EVERY_S;
+            }
+            arrive = at;
+            src_next += src_period;
+
+            if (fill + PACKET_FRAMES > RING_FRAMES) {
+                if (started) {
+                    overruns++;
+                }
+            } else {
+                fill += PACKET_FRAMES;
+            }
+        }
+
+        if (!started) {
+            if (fill >= drift.target) {
+                started = 1;
+                audio_drift_prime(&drift);
+            }
+            continue;
+        }
+
+        double need = CHUNK_FRAMES * (1.0 + drift.ppm * 1e-6);
+        if (fill < need) {
+            // the writer stops and primes again, the integral term is kept
+            underruns++;
+            started = 0;
+            fill = 0.0;
+            continue;
+        } else {
+            fill -= need;
+        }
+
+        audio_drift_update(&drift, (uint32_t)fill);
+
+        if (t >= SETTLE_SECONDS) {
+            if (drift.ppm < ppm_min) ppm_min = drift.ppm;
+            if (drift.ppm > ppm_max) ppm_max = drift.ppm;
+            if (fill < fill_min) fill_min = fill;
+            if (fill > fill_max) fill_max = fill;
+            ppm_sum  += drift.ppm;
+            fill_sum += fill;
+            settled++;
+        }
+    }
+
+    double ppm_avg  = ppm_sum / settled;
+    double fill_avg = fill_sum / settled;
+    double fill_err = fabs(fill_avg - drift.target) / drift.target;
+
+    int fail = underruns || overruns
+            || fabs(ppm_avg - src_ppm) > PPM_TOLERANCE
+            || fill_err > FILL_TOLERANCE;
+
+    printf("%-4s source %+5.0f ppm: estimate %+7.1f ppm [%+7.1f, %+7.1f], "
+           "fill %6.0f [%4.0f, %4.0f]/%u, underruns %u, overruns %u\n",
+           fail ? "FAIL" : "ok", src_ppm, ppm_avg, ppm_min, ppm_max,
+           fill_avg, fill_min, fill_max, drift.target, underruns, overruns);
+
+    return fail;
+}
+
+int main(void)
+{
+    static const double ppm[] = {-800.0, -300.0, 0.0, 250.0, 800.0};
+    int fail = 0;
+
+    for (unsigned i = 0; i < sizeof(ppm) / sizeof(ppm[0]); i++) {
+        fail |= run(ppm[i]);
+    }
+
+    return fail;
+}
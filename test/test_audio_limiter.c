@@ -0,0 +1,244 @@
+/*
+ * test_audio_limiter.c
+ *
+ *  Created on: 2026-10-17 21:40
+ *      Author: agent <agent@local>
+ */
+
+/*
+ * Generated-signal checks of the look-ahead limiter: a full scale step, a
+ * loud burst in a quiet tone and a sine right at the ceiling. The output must
+ * never exceed the ceiling, must recover after the burst and must leave a
+ * signal that is already under the ceiling untouched. Built with a ratio
+ * above 1, steady sines around the compressor threshold check the gain curve
+ * and the reported gain reduction instead of the sine at the ceiling. They are
+ * square waves, so the peak envelope settles on the level itself.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "user/audio_limiter.h"
+
+#define RATE        (44100)
+#define BLOCK       (128)
+#define DELAY       (AUDIO_LIMITER_LOOKAHEAD - 1)
+#define SECONDS     (2)
+#define FRAMES      (RATE * SECONDS / BLOCK * BLOCK)
+
+static int16_t in[FRAMES * 2];
+static int16_t out[FRAMES * 2];
+
+static int32_t ceiling;
+static int fail;
+
+static void check(int ok, const char *name, const char *fmt, double value)
+{
+    printf("%-4s %-32s ", ok ? "ok" : "FAIL", name);
+    printf(fmt, value);
+    printf("\n");
+
+    fail |= !ok;
+}
+
+static void run(void)
+{
+    audio_limiter_init();
+
+    memcpy(out, in, sizeof(out));
+    for (uint32_t i = 0; i < FRAMES; i += BLOCK) {
+        audio_limiter_process(&out[i * 2], BLOCK);
+    }
+}
+
+static int32_t peak(const int16_t *data, uint32_t from, uint32_t to)
+{
+    int32_t p = 0;
+
+    for (uint32_t i = from * 2; i < to * 2; i++) {
+        if (abs(data[i]) > p) {
+            p = abs(data[i]);
+        }
+    }
+
+    return p;
+}
+
+/* worst output / delayed input ratio over a range, in dB */
+static double gain_db(uint32_t from, uint32_t to, int worst_low)
+{
+    double g = worst_low ? 1e9 : 0.0;
+
+    for (uint32_t i = from; i < to; i++) {
+        int32_t x = in[(i - DELAY) * 2];
+        if (abs(x) < 1000) {
+            continue;
+        }
+        double r = (double)out[i * 2] / x;
+        g = worst_low ? fmin(g, r) : fmax(g, r);
+    }
+
+    return 20.0 * log10(g);
+}
+
+static void fill_sine(uint32_t from, uint32_t to, double amp, double freq)
+{
+    for (uint32_t i = from; i < to; i++) {
+        int16_t x = lround(amp * sin(2.0 * M_PI * freq * i / RATE));
+        in[i * 2]     = x;
+        in[i * 2 + 1] = x;
+    }
+}
+
+#if CONFIG_AUDIO_COMPRESSOR_RATIO > 1
+/* static compressor curve for a steady peak level, in dB */
+static double comp_gain_db(double level)
+{
+    double over = level + CONFIG_AUDIO_COMPRESSOR_THRESHOLD;
+
+    return over > 0.0 ? -over * (1.0 - 1.0 / CONFIG_AUDIO_COMPRESSOR_RATIO) : 0.0;
+}
+#endif
+
+static void test_step(void)
+{
+    memset(in, 0x00, sizeof(in));
+    for (uint32_t i = RATE / 2; i < FRAMES; i++) {
+        in[i * 2]     = INT16_MAX;
+        in[i * 2 + 1] = INT16_MIN;
+    }
+
+    run();
+
+    check(peak(out, 0, FRAMES) <= ceiling + 1, "step: output peak", "%.0f", peak(out, 0, FRAMES));
+#if CONFIG_AUDIO_COMPRESSOR_RATIO > 1
+    double settled = fmin(ceiling, INT16_MAX * pow(10.0, comp_gain_db(0.0) / 20.0));
+    check(fabs(20.0 * log10(peak(out, FRAMES - RATE / 4, FRAMES) / settled)) < 0.2, "step: settled level", "%.0f",
+          peak(out, FRAMES - RATE / 4, FRAMES));
+#else
+    check(peak(out, FRAMES - RATE / 4, FRAMES) >= ceiling - 2, "step: settled level", "%.0f",
+          peak(out, FRAMES - RATE / 4, FRAMES));
+#endif
+}
+
+static void test_burst(void)
+{
+    uint32_t on  = RATE / 2;
+    uint32_t off = RATE / 2 + RATE / 20;
+
+    fill_sine(0, FRAMES, 3000.0, 997.0);
+    fill_sine(on, off, 32767.0, 997.0);
+
+    run();
+
+    check(peak(out, 0, FRAMES) <= ceiling + 1, "burst: output peak", "%.0f", peak(out, 0, FRAMES));
+    check(gain_db(DELAY, on, 1) > -0.01, "burst: gain before", "%+.3f dB", gain_db(DELAY, on, 1));
+    // 50 ms release, ten time constants later the quiet tone is back at unity gain
+    check(gain_db(off + DELAY + RATE / 2, FRAMES, 1) > -0.01, "burst: gain 500 ms after", "%+.3f dB",
+          gain_db(off + DELAY + RATE / 2, FRAMES, 1));
+}
+
+#if CONFIG_AUDIO_COMPRESSOR_RATIO > 1
+/* output / delayed input RMS ratio over a range, in dB */
+static double rms_gain_db(uint32_t from, uint32_t to)
+{
+    double si = 0.0, so = 0.0;
+
+    for (uint32_t i = from; i < to; i++) {
+        si += (double)in[(i - DELAY) * 2] * in[(i - DELAY) * 2];
+        so += (double)out[i * 2] * out[i * 2];
+    }
+
+    return 10.0 * log10(so / si);
+}
+
+static void fill_square(uint32_t from, uint32_t to, double amp, uint32_t period)
+{
+    for (uint32_t i = from; i < to; i++) {
+        int16_t x = lround((i % period < period / 2) ? amp : -amp);
+        in[i * 2]     = x;
+        in[i * 2 + 1] = x;
+    }
+}
+
+static void test_compressor_level(double level)
+{
+    char name[32];
+    uint32_t settle = FRAMES - RATE / 4;
+    double expect = comp_gain_db(level);
+
+    fill_square(0, FRAMES, 32768.0 * pow(10.0, level / 20.0), 44);
+
+    audio_limiter_init();
+
+    memcpy(out, in, sizeof(out));
+    for (uint32_t i = 0; i < settle; i += BLOCK) {
+        audio_limiter_process(&out[i * 2], BLOCK);
+    }
+    audio_limiter_get_reduction();
+    for (uint32_t i = settle; i < FRAMES; i += BLOCK) {
+        audio_limiter_process(&out[i * 2], BLOCK);
+    }
+
+    double gain = rms_gain_db(settle, FRAMES);
+    double reduction = audio_limiter_get_reduction() / 10.0;
+
+    snprintf(name, sizeof(name), "comp %+.0f dBFS: gain", level);
+    check(fabs(gain - expect) < 0.2, name, "%+.3f dB", gain);
+    // reported in 0.1 dB steps, truncated
+    snprintf(name, sizeof(name), "comp %+.0f dBFS: reduction", level);
+    check(fabs(reduction + gain) < 0.15, name, "%.1f dB", reduction);
+}
+
+static void test_compressor(void)
+{
+    test_compressor_level(-CONFIG_AUDIO_COMPRESSOR_THRESHOLD - 6.0);
+    test_compressor_level(-CONFIG_AUDIO_COMPRESSOR_THRESHOLD + 3.0);
+    test_compressor_level(-CONFIG_AUDIO_COMPRESSOR_THRESHOLD + 6.0);
+    test_compressor_level(-CONFIG_AUDIO_COMPRESSOR_THRESHOLD + 9.0);
+}
+#else
+static void test_ceiling(void)
+{
+    fill_sine(0, FRAMES, ceiling, 997.0);
+
+    run();
+
+    check(peak(out, 0, FRAMES) <= ceiling + 1, "ceiling sine: output peak", "%.0f", peak(out, 0, FRAMES));
+    check(gain_db(DELAY, FRAMES, 1) > -0.01, "ceiling sine: min gain", "%+.3f dB", gain_db(DELAY, FRAMES, 1));
+    check(gain_db(DELAY, FRAMES, 0) < 0.01, "ceiling sine: max gain", "%+.3f dB", gain_db(DELAY, FRAMES, 0));
+}
+#endif
+
+static void bench(void)
+{
+    srand(1);
+    for (uint32_t i = 0; i < FRAMES * 2; i++) {
+        in[i] = rand() % 65536 - 32768;
+    }
+
+    clock_t t = clock();
+    run();
+    t = clock() - t;
+
+    printf("     random full scale: %.1f ns/frame\n", 1e9 * t / CLOCKS_PER_SEC / FRAMES);
+}
+
+int main(void)
+{
+    ceiling = lroundf(32768.0f * powf(10.0f, -CONFIG_AUDIO_LIMITER_CEILING / 20.0f));
+
+    test_step();
+    test_burst();
+#if CONFIG_AUDIO_COMPRESSOR_RATIO > 1
+    test_compressor();
+#else
+    test_ceiling();
+#endif
+    bench();
+
+    return fail;
+}
@@ -0,0 +1,149 @@
+/*
+ * test_vfx_color.c
+ *
+ *  Created on: 2026-10-17 22:40
+ *      Author: agent <agent@local>
+ */
+
+/*
+ * Checks vfx_get_color() over the whole 512x512 hue/lightness grid against a
+ * float HSL model of the same mapping: full saturation, hue color_h / 512 of
+ * the circle, lightness 0 black, 255 the pure hue and 511 white. Built once for
+ * the cube (RGB888) and once for the panels (RGB565).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "user/vfx_core.h"
+
+#ifdef CONFIG_VFX_OUTPUT_CUBE0414
+#define FORMAT      "RGB888"
+#define ERR_MAX     (2)     // 8-bit LSB, two integer roundings in the ramp and the lightness scale
+#else
+#define FORMAT      "RGB565"
+#define ERR_MAX     (1)     // LSB of the 5/6-bit channels
+#endif
+
+static void reference(uint16_t color_h, uint16_t color_l, double rgb[3])
+{
+    double h = color_h / 512.0 * 6.0;
+    double x = h - floor(h);
+    double hue[3];
+
+    switch ((int)h) {
+        case 0:  hue[0] = 1.0;     hue[1] = x;       hue[2] = 0.0;     break;
+        case 1:  hue[0] = 1.0 - x; hue[1] = 1.0;     hue[2] = 0.0;     break;
+        case 2:  hue[0] = 0.0;     hue[1] = 1.0;     hue[2] = x;       break;
+        case 3:  hue[0] = 0.0;     hue[1] = 1.0 - x; hue[2] = 1.0;     break;
+        case 4:  hue[0] = x;       hue[1] = 0.0;     hue[2] = 1.0;     break;
+        default: hue[0] = 1.0;     hue[1] = 0.0;     hue[2] = 1.0 - x; break;
+    }
+
+    for (int c = 0; c < 3; c++) {
+        if (color_l < 256) {
+            rgb[c] = 255.0 * hue[c] * (color_l + 1) / 256.0;
+        } else {
+            rgb[c] = 255.0 * (hue[c] + (1.0 - hue[c]) * (color_l - 255) / 256.0);
+        }
+    }
+}
+
+static void unpack(uint32_t color, int rgb[3])
+{
+#ifdef CONFIG_VFX_OUTPUT_CUBE0414
+    rgb[0] = color >> 16 & 0xFF;
+    rgb[1] = color >> 8 & 0xFF;
+    rgb[2] = color & 0xFF;
+#else
+    rgb[0] = color >> 11 & 0x1F;
+    rgb[1] = color >> 5 & 0x3F;
+    rgb[2] = color & 0x1F;
+#endif
+}
+
+static void quantize(const double ref[3], double q[3])
+{
+#ifdef CONFIG_VFX_OUTPUT_CUBE0414
+    for (int c = 0; c < 3; c++) {
+        q[c] = ref[c];
+    }
+#else
+    // the panels take the top bits of each 8-bit channel
+    q[0] = floor(round(ref[0]) / 8.0);
+    q[1] = floor(round(ref[1]) / 4.0);
+    q[2] = floor(round(ref[2]) / 8.0);
+#endif
+}
+
+int main(void)
+{
+    double err_max = 0.0, err_sum = 0.0;
+    int worst_h = 0, worst_l = 0;
+    int fail = 0;
+
+    for (int l = 0; l < 512; l++) {
+        for (int h = 0; h < 512; h++) {
+            double ref[3], q[3];
+            int rgb[3];
+
+            reference(h, l, ref);
+            quantize(ref, q);
+            unpack(vfx_get_color(h, l), rgb);
+
+            for (int c = 0; c < 3; c++) {
+                double err = fabs(rgb[c] - q[c]);
+                err_sum += err;
+                if (err > err_max) {
+                    err_max = err;
+                    worst_h = h;
+                    worst_l = l;
+                }
+            }
+        }
+    }
+
+    // the anchors of the mapping have to be exact
+    static const struct {
+        uint16_t h, l;
+        uint32_t color;
+    } anchors[] = {
+#ifdef CONFIG_VFX_OUTPUT_CUBE0414
+        {0,   255, 0xFF0000}, {256, 255, 0x00FFFF}, {0,   127, 0x7F0000},
+        {0,   0,   0x000000}, {0,   511, 0xFFFFFF}, {256, 511, 0xFFFFFF},
+#else
+        {0,   255, 0xF800},   {256, 255, 0x07FF},   {0,   127, 0x7800},
+        {0,   0,   0x0000},   {0,   511, 0xFFFF},   {256, 511, 0xFFFF},
+#endif
+    };
+
+    for (unsigned i = 0; i < sizeof(anchors) / sizeof(anchors[0]); i++) {
+        uint32_t color = vfx_get_color(anchors[i].h, anchors[i].l);
+        if (color != anchors[i].color) {
+            printf("FAIL %s h %3u l %3u: 0x%06X, expected 0x%06X\n", FORMAT,
+                   anchors[i].h, anchors[i].l, color, anchors[i].color);
+            fail = 1;
+        }
+    }
+
+    fail |= err_max > ERR_MAX;
+
+    printf("%-4s %s: max error %.2f LSB at h %d l %d, mean %.3f LSB\n", fail ? "FAIL" : "ok", FORMAT,
+           err_max, worst_h, worst_l, err_sum / (512.0 * 512.0 * 3.0));
+
+    volatile uint32_t sink = 0;
+    clock_t t = clock();
+    for (int n = 0; n < 64; n++) {
+        for (int i = 0; i < 512 * 512; i++) {
+            sink += vfx_get_color(i & 0x1FF, i >> 9);
+        }
+    }
+    t = clock() - t;
+    (void)sink;
+
+    printf("     %.2f ns per color on this host\n", 1e9 * t / CLOCKS_PER_SEC / (64.0 * 512 * 512));
+
+    return fail;
+}